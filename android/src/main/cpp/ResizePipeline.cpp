@@ -0,0 +1,640 @@
+//
+// Created by Marc Rousavy on 25.01.24
+//
+
+#include "ResizePipeline.h"
+#include "libyuv.h"
+#include <algorithm>
+#include <android/log.h>
+#include <cstring>
+#include <fbjni/fbjni.h>
+#include <jni.h>
+
+namespace vision {
+
+using namespace facebook;
+
+int getChannelCount(PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case RGB:
+    case BGR:
+      return 3;
+    case ARGB:
+    case RGBA:
+    case BGRA:
+    case ABGR:
+      return 4;
+  }
+}
+
+int getBytesPerChannel(DataType type) {
+  switch (type) {
+    case UINT8:
+      return sizeof(uint8_t);
+    case FLOAT32:
+      return sizeof(float_t);
+  }
+}
+
+int getBytesPerPixel(PixelFormat pixelFormat, DataType type) {
+  return getChannelCount(pixelFormat) * getBytesPerChannel(type);
+}
+
+/* Returns the byte offsets of R, G and B within a pixel, in libyuv memory layout (e.g. libyuv's ARGB is [B, G, R, A]) */
+void getRGBOffsets(PixelFormat pixelFormat, int& r, int& g, int& b) {
+  switch (pixelFormat) {
+    case RGB:
+    case ABGR:
+      r = 0, g = 1, b = 2;
+      break;
+    case BGR:
+    case ARGB:
+      r = 2, g = 1, b = 0;
+      break;
+    case RGBA:
+      r = 3, g = 2, b = 1;
+      break;
+    case BGRA:
+      r = 1, g = 2, b = 3;
+      break;
+  }
+}
+
+libyuv::RotationMode getRotationModeForRotation(Rotation rotation) {
+  switch (rotation) {
+    case Rotation0:
+      return libyuv::RotationMode::kRotate0;
+    case Rotation90:
+      return libyuv::RotationMode::kRotate90;
+    case Rotation180:
+      return libyuv::RotationMode::kRotate180;
+    case Rotation270:
+      return libyuv::RotationMode::kRotate270;
+  }
+}
+
+int FrameBuffer::bytesPerRow() const {
+  size_t bytesPerPixel = getBytesPerPixel(pixelFormat, dataType);
+  return width * bytesPerPixel;
+}
+
+uint8_t* FrameBuffer::data() const {
+  return buffer->getDirectBytes();
+}
+
+global_ref<JByteBuffer> ResizePipeline::allocateBuffer(size_t size, std::string debugName) {
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Allocating %s Buffer with size %zu...", debugName.c_str(), size);
+  local_ref<JByteBuffer> buffer = JByteBuffer::allocateDirect(size);
+  buffer->order(JByteOrder::nativeOrder());
+  return make_global(buffer);
+}
+
+FrameBuffer ResizePipeline::imageToFrameBuffer(const SourceImage& image) {
+  int width = image.width;
+  int height = image.height;
+
+  size_t channels = getChannelCount(PixelFormat::ARGB);
+  size_t channelSize = getBytesPerChannel(DataType::UINT8);
+  size_t argbSize = width * height * channels * channelSize;
+  if (_argbBuffer == nullptr || _argbBuffer->getDirectSize() != argbSize) {
+    _argbBuffer = allocateBuffer(argbSize, "_argbBuffer");
+  }
+
+  FrameBuffer destination = {
+      .width = width,
+      .height = height,
+      .pixelFormat = PixelFormat::ARGB,
+      .dataType = DataType::UINT8,
+      .buffer = _argbBuffer,
+  };
+
+  int status;
+
+  switch (image.format) {
+    case SourceImageFormat::RGBA_8888: {
+      __android_log_write(ANDROID_LOG_INFO, TAG, "Converting RGBA 8888 -> ARGB 8888...");
+      const SourcePlane& rgbaPlane = image.planes[0];
+      // 1. Convert from RGBA -> ARGB
+      status = libyuv::RGBAToARGB(rgbaPlane.data, rgbaPlane.rowStride, destination.data(), width * channels * channelSize, width, height);
+
+      if (status != 0) {
+        [[unlikely]];
+        throw std::runtime_error("Failed to convert RGBA 8888 to ARGB! Error: " + std::to_string(status));
+      }
+      break;
+    }
+    default: /* SourceImageFormat.YUV_420_888 */
+    {
+      __android_log_write(ANDROID_LOG_INFO, TAG, "Converting YUV 4:2:0 -> ARGB 8888...");
+      if (image.planesCount != 3) {
+        [[unlikely]];
+        throw std::runtime_error("YUV Image does not have 3 planes! Are you sure this is a 4:2:0 YUV format?");
+      }
+      const SourcePlane& yPlane = image.planes[0];
+      const SourcePlane& uPlane = image.planes[1];
+      const SourcePlane& vPlane = image.planes[2];
+
+      size_t uvPixelStride = uPlane.pixelStride;
+      if (uPlane.pixelStride != vPlane.pixelStride) {
+        [[unlikely]];
+        throw std::runtime_error("U and V planes do not have the same pixel stride! Are you sure this is a 4:2:0 YUV format?");
+      }
+
+      // 1. Convert from YUV -> ARGB
+      status = libyuv::Android420ToARGB(yPlane.data, yPlane.rowStride, uPlane.data, uPlane.rowStride, vPlane.data, vPlane.rowStride,
+                                        uvPixelStride, destination.data(), width * channels * channelSize, width, height);
+
+      if (status != 0) {
+        [[unlikely]];
+        throw std::runtime_error("Failed to convert YUV 4:2:0 to ARGB! Error: " + std::to_string(status));
+      }
+      break;
+    }
+  }
+
+  return destination;
+}
+
+std::string rectToString(int x, int y, int width, int height) {
+  return std::to_string(x) + ", " + std::to_string(y) + " @ " + std::to_string(width) + "x" + std::to_string(height);
+}
+
+FrameBuffer ResizePipeline::cropARGBBuffer(const FrameBuffer& frameBuffer, int x, int y, int width, int height) {
+  if (width == frameBuffer.width && height == frameBuffer.height && x == 0 && y == 0) {
+    // already in correct size.
+    return frameBuffer;
+  }
+
+  auto rectString = rectToString(0, 0, frameBuffer.width, frameBuffer.height);
+  auto targetString = rectToString(x, y, width, height);
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Cropping [%s] ARGB buffer to [%s]...", rectString.c_str(), targetString.c_str());
+
+  size_t channels = getChannelCount(PixelFormat::ARGB);
+  size_t channelSize = getBytesPerChannel(DataType::UINT8);
+  size_t argbSize = width * height * channels * channelSize;
+  if (_cropBuffer == nullptr || _cropBuffer->getDirectSize() != argbSize) {
+    _cropBuffer = allocateBuffer(argbSize, "_cropBuffer");
+  }
+  FrameBuffer destination = {
+      .width = width,
+      .height = height,
+      .pixelFormat = PixelFormat::ARGB,
+      .dataType = DataType::UINT8,
+      .buffer = _cropBuffer,
+  };
+
+  int status = libyuv::ConvertToARGB(frameBuffer.data(), frameBuffer.height * frameBuffer.bytesPerRow(), destination.data(),
+                                     destination.bytesPerRow(), x, y, frameBuffer.width, frameBuffer.height, width, height,
+                                     libyuv::kRotate0, libyuv::FOURCC_ARGB);
+  if (status != 0) {
+    [[unlikely]];
+    throw std::runtime_error("Failed to crop ARGB Buffer! Status: " + std::to_string(status));
+  }
+
+  return destination;
+}
+
+FrameBuffer ResizePipeline::mirrorARGBBuffer(const FrameBuffer& frameBuffer, bool mirror) {
+  if (!mirror) {
+    return frameBuffer;
+  }
+
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Mirroring ARGB buffer...");
+
+  size_t channels = getChannelCount(PixelFormat::ARGB);
+  size_t channelSize = getBytesPerChannel(DataType::UINT8);
+  size_t argbSize = frameBuffer.width * frameBuffer.height * channels * channelSize;
+  if (_mirrorBuffer == nullptr || _mirrorBuffer->getDirectSize() != argbSize) {
+    _mirrorBuffer = allocateBuffer(argbSize, "_mirrorBuffer");
+  }
+  FrameBuffer destination = {
+      .width = frameBuffer.width,
+      .height = frameBuffer.height,
+      .pixelFormat = PixelFormat::ARGB,
+      .dataType = DataType::UINT8,
+      .buffer = _mirrorBuffer,
+  };
+
+  int status = libyuv::ARGBMirror(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
+                                  frameBuffer.width, frameBuffer.height);
+  if (status != 0) {
+    [[unlikely]];
+    throw std::runtime_error("Failed to mirror ARGB Buffer! Status: " + std::to_string(status));
+  }
+
+  return destination;
+}
+
+FrameBuffer ResizePipeline::rotateARGBBuffer(const FrameBuffer& frameBuffer, Rotation rotation) {
+  if (rotation == Rotation::Rotation0) {
+    return frameBuffer;
+  }
+
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Rotating ARGB buffer by %zu degrees...", static_cast<int>(rotation));
+
+  int rotatedWidth, rotatedHeight;
+  if (rotation == Rotation90 || rotation == Rotation270) {
+    // flipped to the side
+    rotatedWidth = frameBuffer.height;
+    rotatedHeight = frameBuffer.width;
+  } else {
+    // still uprighht, maybe upside down.
+    rotatedWidth = frameBuffer.width;
+    rotatedHeight = frameBuffer.height;
+  }
+
+  size_t channels = getChannelCount(PixelFormat::ARGB);
+  size_t channelSize = getBytesPerChannel(DataType::UINT8);
+  size_t destinationStride = rotatedWidth * channels * channelSize;
+  size_t rotateSize = frameBuffer.buffer->getDirectSize();
+
+  if (_rotatedBuffer == nullptr || _rotatedBuffer->getDirectSize() != rotateSize) {
+    _rotatedBuffer = allocateBuffer(rotateSize, "_rotatedBuffer");
+  }
+
+  FrameBuffer destination = {
+      .width = rotatedWidth,
+      .height = rotatedHeight,
+      .pixelFormat = PixelFormat::ARGB,
+      .dataType = DataType::UINT8,
+      .buffer = _rotatedBuffer,
+  };
+
+  libyuv::RotationMode rotationMode = getRotationModeForRotation(rotation);
+  int status = libyuv::ARGBRotate(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destinationStride, frameBuffer.width,
+                                  frameBuffer.height, rotationMode);
+  if (status != 0) {
+    [[unlikely]];
+    throw std::runtime_error("Failed to rotate ARGB Buffer! Status: " + std::to_string(status));
+  }
+
+  return destination;
+}
+
+FrameBuffer ResizePipeline::scaleARGBBuffer(const FrameBuffer& frameBuffer, int width, int height) {
+  if (width == frameBuffer.width && height == frameBuffer.height) {
+    // already in correct size.
+    return frameBuffer;
+  }
+  auto rectString = rectToString(0, 0, frameBuffer.width, frameBuffer.height);
+  auto targetString = rectToString(0, 0, width, height);
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Scaling [%s] ARGB buffer to [%s]...", rectString.c_str(), targetString.c_str());
+
+  size_t channels = getChannelCount(PixelFormat::ARGB);
+  size_t channelSize = getBytesPerChannel(DataType::UINT8);
+  size_t argbSize = width * height * channels * channelSize;
+  if (_scaleBuffer == nullptr || _scaleBuffer->getDirectSize() != argbSize) {
+    _scaleBuffer = allocateBuffer(argbSize, "_scaleBuffer");
+  }
+  FrameBuffer destination = {
+      .width = width,
+      .height = height,
+      .pixelFormat = PixelFormat::ARGB,
+      .dataType = DataType::UINT8,
+      .buffer = _scaleBuffer,
+  };
+
+  int status = libyuv::ARGBScale(frameBuffer.data(), frameBuffer.bytesPerRow(), frameBuffer.width, frameBuffer.height, destination.data(),
+                                 destination.bytesPerRow(), width, height, libyuv::FilterMode::kFilterBilinear);
+  if (status != 0) {
+    [[unlikely]];
+    throw std::runtime_error("Failed to scale ARGB Buffer! Status: " + std::to_string(status));
+  }
+
+  return destination;
+}
+
+/* Blends two ARGB pixels by f / 256 towards b, with two channels per 32-bit multiply instead of one multiply per channel */
+inline uint32_t lerpARGB(uint32_t a, uint32_t b, uint32_t f) {
+  uint32_t rb = (((a & 0x00FF00FF) * (256 - f) + (b & 0x00FF00FF) * f + 0x00800080) >> 8) & 0x00FF00FF;
+  uint32_t ag = (((a >> 8) & 0x00FF00FF) * (256 - f) + ((b >> 8) & 0x00FF00FF) * f + 0x00800080) & 0xFF00FF00;
+  return rb | ag;
+}
+
+inline uint32_t loadARGB(const uint8_t* pixel) {
+  uint32_t value;
+  memcpy(&value, pixel, 4);
+  return value;
+}
+
+/* Bilinearly samples the 4 channels at the given 24.8 fixed-point source position, or returns 0 if it is outside of the source */
+inline uint32_t sampleBilinear(const uint8_t* src, int srcStride, int srcWidth, int srcHeight, int32_t fixedX, int32_t fixedY) {
+  int x0 = fixedX >> 8;
+  int y0 = fixedY >> 8;
+  if (x0 < -1 || y0 < -1 || x0 >= srcWidth || y0 >= srcHeight) {
+    return 0;
+  }
+  // Clamp to the edges so the border pixels blend with themselves
+  int x1 = std::min(x0 + 1, srcWidth - 1);
+  int y1 = std::min(y0 + 1, srcHeight - 1);
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+
+  const uint8_t* row0 = src + y0 * srcStride;
+  const uint8_t* row1 = src + y1 * srcStride;
+  uint32_t top = lerpARGB(loadARGB(row0 + x0 * 4), loadARGB(row0 + x1 * 4), fixedX & 0xFF);
+  uint32_t bottom = lerpARGB(loadARGB(row1 + x0 * 4), loadARGB(row1 + x1 * 4), fixedX & 0xFF);
+  return lerpARGB(top, bottom, fixedY & 0xFF);
+}
+
+inline int64_t floorDiv(int64_t a, int64_t b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/* Narrows [begin, end) to the x for which lo <= start + x * step <= hi */
+inline void narrowSpan(int64_t start, int64_t step, int64_t lo, int64_t hi, int64_t& begin, int64_t& end) {
+  if (step < 0) {
+    narrowSpan(-start, -step, -hi, -lo, begin, end);
+  } else if (step == 0) {
+    if (start < lo || start > hi) {
+      end = begin;
+    }
+  } else {
+    begin = std::max(begin, -floorDiv(start - lo, step));
+    end = std::min(end, floorDiv(hi - start, step) + 1);
+  }
+}
+
+constexpr double kMinPerspectiveW = 1e-9;
+
+/* Samples every target pixel from the source. Source coordinates are advanced incrementally per row instead of multiplying per pixel. */
+template <bool Perspective>
+void warpARGBRows(const FrameBuffer& source, const FrameBuffer& destination, const double m[9]) {
+  const uint8_t* src = source.data();
+  int srcStride = source.bytesPerRow();
+  uint8_t* dst = destination.data();
+  int dstStride = destination.bytesPerRow();
+
+  for (int y = 0; y < destination.height; y++) {
+    uint32_t* row = reinterpret_cast<uint32_t*>(dst + y * dstStride);
+    // Map pixel centers, and shift back by half a pixel for sampling
+    double u = m[0] * 0.5 + m[1] * (y + 0.5) + m[2];
+    double v = m[3] * 0.5 + m[4] * (y + 0.5) + m[5];
+    if constexpr (Perspective) {
+      double w = m[6] * 0.5 + m[7] * (y + 0.5) + m[8];
+      for (int x = 0; x < destination.width; x++, u += m[0], v += m[3], w += m[6]) {
+        if (w <= kMinPerspectiveW) {
+          // Behind the camera (or at infinity), dividing by w would produce Inf/NaN
+          row[x] = 0;
+          continue;
+        }
+        double sourceX = u / w - 0.5;
+        double sourceY = v / w - 0.5;
+        // Clamp before converting to fixed-point, anything out there is outside of the source anyways
+        int32_t fixedX = static_cast<int32_t>(std::clamp(sourceX, -2.0, 1e6) * 256.0);
+        int32_t fixedY = static_cast<int32_t>(std::clamp(sourceY, -2.0, 1e6) * 256.0);
+        row[x] = sampleBilinear(src, srcStride, source.width, source.height, fixedX, fixedY);
+      }
+    } else {
+      // 16.16 fixed-point, so each step is a single integer add
+      int64_t startX = static_cast<int64_t>((u - 0.5) * 65536.0);
+      int64_t startY = static_cast<int64_t>((v - 0.5) * 65536.0);
+      int64_t stepX = static_cast<int64_t>(m[0] * 65536.0);
+      int64_t stepY = static_cast<int64_t>(m[3] * 65536.0);
+
+      // Pixels whose 2x2 neighbourhood is fully inside of the source don't need any bounds checks
+      int64_t interiorBegin = 0;
+      int64_t interiorEnd = destination.width;
+      narrowSpan(startX, stepX, 0, (static_cast<int64_t>(source.width - 1) << 16) - 1, interiorBegin, interiorEnd);
+      narrowSpan(startY, stepY, 0, (static_cast<int64_t>(source.height - 1) << 16) - 1, interiorBegin, interiorEnd);
+      int begin = static_cast<int>(std::min<int64_t>(interiorBegin, destination.width));
+      int end = static_cast<int>(std::clamp<int64_t>(interiorEnd, begin, destination.width));
+
+      auto sampleEdge = [&](int x) {
+        int64_t fixedX = startX + x * stepX;
+        int64_t fixedY = startY + x * stepY;
+        int32_t sampleX = static_cast<int32_t>(std::clamp<int64_t>(fixedX >> 8, -512, 1 << 30));
+        int32_t sampleY = static_cast<int32_t>(std::clamp<int64_t>(fixedY >> 8, -512, 1 << 30));
+        row[x] = sampleBilinear(src, srcStride, source.width, source.height, sampleX, sampleY);
+      };
+      for (int x = 0; x < begin; x++) {
+        sampleEdge(x);
+      }
+      int64_t fixedX = startX + begin * stepX;
+      int64_t fixedY = startY + begin * stepY;
+      for (int x = begin; x < end; x++, fixedX += stepX, fixedY += stepY) {
+        const uint8_t* row0 = src + (fixedY >> 16) * srcStride + (fixedX >> 16) * 4;
+        const uint8_t* row1 = row0 + srcStride;
+        uint32_t fx = (fixedX >> 8) & 0xFF;
+        uint32_t top = lerpARGB(loadARGB(row0), loadARGB(row0 + 4), fx);
+        uint32_t bottom = lerpARGB(loadARGB(row1), loadARGB(row1 + 4), fx);
+        row[x] = lerpARGB(top, bottom, (fixedY >> 8) & 0xFF);
+      }
+      for (int x = end; x < destination.width; x++) {
+        sampleEdge(x);
+      }
+    }
+  }
+}
+
+FrameBuffer ResizePipeline::warpARGBBuffer(const FrameBuffer& frameBuffer, const double transform[9], int width, int height) {
+  auto rectString = rectToString(0, 0, frameBuffer.width, frameBuffer.height);
+  auto targetString = rectToString(0, 0, width, height);
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Warping [%s] ARGB buffer to [%s]...", rectString.c_str(), targetString.c_str());
+
+  size_t channels = getChannelCount(PixelFormat::ARGB);
+  size_t channelSize = getBytesPerChannel(DataType::UINT8);
+  size_t argbSize = width * height * channels * channelSize;
+  if (_warpBuffer == nullptr || _warpBuffer->getDirectSize() != argbSize) {
+    _warpBuffer = allocateBuffer(argbSize, "_warpBuffer");
+  }
+  FrameBuffer destination = {
+      .width = width,
+      .height = height,
+      .pixelFormat = PixelFormat::ARGB,
+      .dataType = DataType::UINT8,
+      .buffer = _warpBuffer,
+  };
+
+  bool isAffine = transform[6] == 0.0 && transform[7] == 0.0 && transform[8] == 1.0;
+  if (isAffine) {
+    warpARGBRows<false>(frameBuffer, destination, transform);
+  } else {
+    warpARGBRows<true>(frameBuffer, destination, transform);
+  }
+
+  return destination;
+}
+
+FrameBuffer ResizePipeline::convertARGBBufferTo(const FrameBuffer& frameBuffer, PixelFormat pixelFormat) {
+  if (frameBuffer.pixelFormat == pixelFormat) {
+    // Already in the correct format.
+    return frameBuffer;
+  }
+
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Converting ARGB Buffer to Pixel Format %zu...", pixelFormat);
+
+  size_t bytesPerPixel = getBytesPerPixel(pixelFormat, frameBuffer.dataType);
+  size_t targetBufferSize = frameBuffer.width * frameBuffer.height * bytesPerPixel;
+  if (_customFormatBuffer == nullptr || _customFormatBuffer->getDirectSize() != targetBufferSize) {
+    _customFormatBuffer = allocateBuffer(targetBufferSize, "_customFormatBuffer");
+  }
+  FrameBuffer destination = {
+      .width = frameBuffer.width,
+      .height = frameBuffer.height,
+      .pixelFormat = pixelFormat,
+      .dataType = frameBuffer.dataType,
+      .buffer = _customFormatBuffer,
+  };
+
+  int error = 0;
+  switch (pixelFormat) {
+    case PixelFormat::ARGB:
+      // do nothing, we're already in ARGB
+      return frameBuffer;
+    case RGB:
+      // RAW is [R, G, B] in libyuv memory layout
+      error = libyuv::ARGBToRAW(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
+                                destination.width, destination.height);
+      break;
+    case BGR:
+      // RGB24 is [B, G, R] in libyuv memory layout
+      error = libyuv::ARGBToRGB24(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
+                                  destination.width, destination.height);
+      break;
+    case RGBA:
+      error = libyuv::ARGBToRGBA(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
+                                 destination.width, destination.height);
+      break;
+    case BGRA:
+      error = libyuv::ARGBToBGRA(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
+                                 destination.width, destination.height);
+      break;
+    case ABGR:
+      error = libyuv::ARGBToABGR(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
+                                 destination.width, destination.height);
+      break;
+  }
+
+  if (error != 0) {
+    [[unlikely]];
+    throw std::runtime_error("Failed to convert ARGB Buffer to target Pixel Format! Error: " + std::to_string(error));
+  }
+
+  return destination;
+}
+
+template <bool WriteFloat>
+void accumulateStats(const FrameBuffer& frameBuffer, float* floatOutput, FrameStats& stats) {
+  int channels = getChannelCount(frameBuffer.pixelFormat);
+  size_t pixelCount = frameBuffer.width * frameBuffer.height;
+  int r, g, b;
+  getRGBOffsets(frameBuffer.pixelFormat, r, g, b);
+
+  uint64_t sum[4] = {0, 0, 0, 0};
+  uint8_t min[4] = {255, 255, 255, 255};
+  uint8_t max[4] = {0, 0, 0, 0};
+  uint32_t histogram[256] = {0};
+
+  const uint8_t* pixel = frameBuffer.data();
+  for (size_t i = 0; i < pixelCount; i++, pixel += channels) {
+    for (int c = 0; c < channels; c++) {
+      uint8_t value = pixel[c];
+      sum[c] += value;
+      min[c] = std::min(min[c], value);
+      max[c] = std::max(max[c], value);
+      if constexpr (WriteFloat) {
+        floatOutput[i * channels + c] = value * (1.0f / 255.0f);
+      }
+    }
+    // BT.601 luma in 8-bit fixed point, weights sum up to 256
+    uint32_t luma = (77 * pixel[r] + 150 * pixel[g] + 29 * pixel[b]) >> 8;
+    histogram[luma]++;
+  }
+
+  stats.isValid = true;
+  stats.channels = channels;
+  stats.pixelCount = pixelCount;
+  std::copy(std::begin(sum), std::end(sum), stats.sum);
+  std::copy(std::begin(min), std::end(min), stats.min);
+  std::copy(std::begin(max), std::end(max), stats.max);
+  std::copy(std::begin(histogram), std::end(histogram), stats.histogram);
+}
+
+FrameBuffer ResizePipeline::convertBufferToDataType(const FrameBuffer& frameBuffer, DataType dataType, FrameStats* stats) {
+  if (stats != nullptr) {
+    stats->scale = dataType == FLOAT32 ? 1.0f / 255.0f : 1.0f;
+  }
+
+  if (frameBuffer.dataType == dataType) {
+    // Already in correct data-type
+    if (stats != nullptr) {
+      // Stats still need one read pass
+      __android_log_write(ANDROID_LOG_INFO, TAG, "Computing Buffer stats...");
+      accumulateStats<false>(frameBuffer, nullptr, *stats);
+    }
+    return frameBuffer;
+  }
+
+  __android_log_print(ANDROID_LOG_INFO, TAG, "Converting ARGB Buffer to Data Type %zu...", dataType);
+
+  size_t targetSize = frameBuffer.width * frameBuffer.height * getBytesPerPixel(frameBuffer.pixelFormat, dataType);
+  if (_customTypeBuffer == nullptr || _customTypeBuffer->getDirectSize() != targetSize) {
+    _customTypeBuffer = allocateBuffer(targetSize, "_customTypeBuffer");
+  }
+  size_t size = frameBuffer.buffer->getDirectSize();
+  FrameBuffer destination = {
+      .width = frameBuffer.width,
+      .height = frameBuffer.height,
+      .pixelFormat = frameBuffer.pixelFormat,
+      .dataType = dataType,
+      .buffer = _customTypeBuffer,
+  };
+
+  int status = 0;
+  switch (dataType) {
+    case UINT8:
+      // it's already uint8
+      return frameBuffer;
+    case FLOAT32: {
+      float* floatData = reinterpret_cast<float*>(destination.data());
+      if (stats != nullptr) {
+        // Accumulate stats in the same pass as the conversion
+        accumulateStats<true>(frameBuffer, floatData, *stats);
+      } else {
+        status = libyuv::ByteToFloat(frameBuffer.data(), floatData, 1.0f / 255.0f, size);
+      }
+      break;
+    }
+  }
+
+  if (status != 0) {
+    [[unlikely]];
+    throw std::runtime_error("Failed to convert Buffer to target Data Type! Error: " + std::to_string(status));
+  }
+
+  return destination;
+}
+
+FrameBuffer ResizePipeline::run(const SourceImage& image, const ResizeOptions& options, FrameStats& stats) {
+  // 1. Convert from YUV/RGBA -> ARGB
+  FrameBuffer result = imageToFrameBuffer(image);
+
+  if (options.hasTransform) {
+    // 2./3. Warp ARGB, samples directly from the full Frame into the target size
+    result = warpARGBBuffer(result, options.transform, options.scaleWidth, options.scaleHeight);
+  } else {
+    // 2. Crop ARGB
+    result = cropARGBBuffer(result, options.cropX, options.cropY, options.cropWidth, options.cropHeight);
+
+    // 3. Scale ARGB
+    result = scaleARGBBuffer(result, options.scaleWidth, options.scaleHeight);
+  }
+
+  // 4. Rotate ARGB
+  result = rotateARGBBuffer(result, options.rotation);
+
+  // 5 Mirror ARGB if needed
+  result = mirrorARGBBuffer(result, options.mirror);
+
+  // 6. Convert from ARGB -> ????
+  result = convertARGBBufferTo(result, options.pixelFormat);
+
+  // 7. Convert from data type to other data type, and compute stats on the way if requested
+  stats.isValid = false;
+  result = convertBufferToDataType(result, options.dataType, options.computeStats ? &stats : nullptr);
+
+  return result;
+}
+
+} // namespace vision
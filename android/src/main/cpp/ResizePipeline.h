@@ -0,0 +1,115 @@
+//
+// Created by Marc Rousavy on 25.01.24
+//
+
+#pragma once
+
+#include <fbjni/ByteBuffer.h>
+#include <fbjni/fbjni.h>
+#include <jni.h>
+#include <string>
+
+namespace vision {
+
+using namespace facebook;
+using namespace jni;
+
+enum PixelFormat { RGB, BGR, ARGB, RGBA, BGRA, ABGR };
+
+/* Those should match Android ImageFormat and PixelFormat constants */
+enum SourceImageFormat { RGBA_8888 = 1, YUV_420_888 = 35 };
+
+enum DataType { UINT8, FLOAT32 };
+
+enum Rotation { Rotation0 = 0, Rotation90 = 90, Rotation180 = 180, Rotation270 = 270 };
+
+struct FrameBuffer {
+  int width;
+  int height;
+  PixelFormat pixelFormat;
+  DataType dataType;
+  global_ref<JByteBuffer> buffer;
+
+  uint8_t* data() const;
+  int bytesPerRow() const;
+};
+
+struct ResizeOptions {
+  int cropX;
+  int cropY;
+  int cropWidth;
+  int cropHeight;
+  int scaleWidth;
+  int scaleHeight;
+  Rotation rotation;
+  bool mirror;
+  PixelFormat pixelFormat;
+  DataType dataType;
+  bool computeStats;
+  // If set, crop and scale are replaced by sampling with this row-major 3x3 matrix (target -> source pixel coordinates)
+  bool hasTransform;
+  double transform[9];
+};
+
+/* Statistics of the resulting buffer, accumulated while converting it to the target data type */
+struct FrameStats {
+  bool isValid;
+  int channels;
+  size_t pixelCount;
+  // Converts uint8 values to the range of the target data type
+  float scale;
+  uint64_t sum[4];
+  uint8_t min[4];
+  uint8_t max[4];
+  uint32_t histogram[256];
+};
+
+struct SourcePlane {
+  const uint8_t* data;
+  size_t size;
+  int rowStride;
+  int pixelStride;
+};
+
+/* A non-owning view of the planes of a YUV_420_888 or RGBA_8888 Image */
+struct SourceImage {
+  int width;
+  int height;
+  int /* SourceImageFormat */ format;
+  int planesCount;
+  SourcePlane planes[3];
+};
+
+/* Runs all conversion steps on a Frame. Owns the intermediate buffers, so it must only be used from one thread at a time. */
+class ResizePipeline {
+public:
+  FrameBuffer run(const SourceImage& image, const ResizeOptions& options, FrameStats& stats);
+  static global_ref<JByteBuffer> allocateBuffer(size_t size, std::string debugName);
+
+private:
+  FrameBuffer imageToFrameBuffer(const SourceImage& image);
+  FrameBuffer cropARGBBuffer(const FrameBuffer& frameBuffer, int x, int y, int width, int height);
+  FrameBuffer scaleARGBBuffer(const FrameBuffer& frameBuffer, int width, int height);
+  FrameBuffer warpARGBBuffer(const FrameBuffer& frameBuffer, const double transform[9], int width, int height);
+  FrameBuffer convertARGBBufferTo(const FrameBuffer& frameBuffer, PixelFormat toFormat);
+  FrameBuffer convertBufferToDataType(const FrameBuffer& frameBuffer, DataType dataType, FrameStats* stats);
+  FrameBuffer rotateARGBBuffer(const FrameBuffer& frameBuffer, Rotation rotation);
+  FrameBuffer mirrorARGBBuffer(const FrameBuffer& frameBuffer, bool mirror);
+
+private:
+  static auto constexpr TAG = "ResizePlugin";
+  // YUV (?x?) -> ARGB (?x?)
+  global_ref<JByteBuffer> _argbBuffer;
+  // ARGB (?x?) -> ARGB (!x!)
+  global_ref<JByteBuffer> _cropBuffer;
+  global_ref<JByteBuffer> _scaleBuffer;
+  global_ref<JByteBuffer> _warpBuffer;
+  global_ref<JByteBuffer> _rotatedBuffer;
+  global_ref<JByteBuffer> _mirrorBuffer;
+  // ARGB (?x?) -> !!!! (?x?)
+  global_ref<JByteBuffer> _customFormatBuffer;
+  // Custom Data Type (e.g. float32)
+  global_ref<JByteBuffer> _customTypeBuffer;
+};
+
+} // namespace vision
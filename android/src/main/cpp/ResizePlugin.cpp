@@ -3,8 +3,10 @@
 //
 
 #include "ResizePlugin.h"
-#include "libyuv.h"
+#include <algorithm>
 #include <android/log.h>
+#include <cmath>
+#include <cstring>
 #include <fbjni/fbjni.h>
 #include <jni.h>
 #include <media/NdkImage.h>
@@ -17,6 +19,11 @@ void ResizePlugin::registerNatives() {
   registerHybrid({
       makeNativeMethod("initHybrid", ResizePlugin::initHybrid),
       makeNativeMethod("resize", ResizePlugin::resize),
+      makeNativeMethod("resizePipelined", ResizePlugin::resizePipelined),
+      makeNativeMethod("getPipelinedTimestamp", ResizePlugin::getPipelinedTimestamp),
+      makeNativeMethod("getPipelinedDataType", ResizePlugin::getPipelinedDataType),
+      makeNativeMethod("getStats", ResizePlugin::getStats),
+      makeNativeMethod("getPipelinedStats", ResizePlugin::getPipelinedStats),
   });
 }
 
@@ -24,409 +31,275 @@ ResizePlugin::ResizePlugin(const jni::alias_ref<jhybridobject>& javaThis) {
   _javaThis = jni::make_global(javaThis);
 }
 
-int getChannelCount(PixelFormat pixelFormat) {
-  switch (pixelFormat) {
-    case RGB:
-    case BGR:
-      return 3;
-    case ARGB:
-    case RGBA:
-    case BGRA:
-    case ABGR:
-      return 4;
-  }
-}
+SourceImage ResizePlugin::getSourceImage(alias_ref<vision::JImage> image) {
+  jni::local_ref<JArrayClass<JImagePlane>> planes = image->getPlanes();
 
-int getBytesPerChannel(DataType type) {
-  switch (type) {
-    case UINT8:
-      return sizeof(uint8_t);
-    case FLOAT32:
-      return sizeof(float_t);
+  SourceImage source = {
+      .width = image->getWidth(),
+      .height = image->getHeight(),
+      .format = image->getFormat(),
+      .planesCount = static_cast<int>(std::min(planes->size(), static_cast<size_t>(3))),
+  };
+  for (int i = 0; i < source.planesCount; i++) {
+    // The Image owns the memory, so the plane stays valid as long as the Image is not closed.
+    jni::local_ref<JImagePlane> plane = planes->getElement(i);
+    jni::local_ref<JByteBuffer> buffer = plane->getBuffer();
+    source.planes[i] = {
+        .data = buffer->getDirectBytes(),
+        .size = buffer->getDirectSize(),
+        .rowStride = plane->getRowStride(),
+        .pixelStride = plane->getPixelStride(),
+    };
   }
+  return source;
 }
 
-int getBytesPerPixel(PixelFormat pixelFormat, DataType type) {
-  return getChannelCount(pixelFormat) * getBytesPerChannel(type);
-}
+local_ref<JArrayDouble> statsToJavaArray(const FrameStats& stats) {
+  if (!stats.isValid) {
+    return nullptr;
+  }
 
-libyuv::RotationMode getRotationModeForRotation(Rotation rotation) {
-  switch (rotation) {
-    case Rotation0:
-      return libyuv::RotationMode::kRotate0;
-    case Rotation90:
-      return libyuv::RotationMode::kRotate90;
-    case Rotation180:
-      return libyuv::RotationMode::kRotate180;
-    case Rotation270:
-      return libyuv::RotationMode::kRotate270;
+  // Layout: [sum * channels, mean * channels, min * channels, max * channels, histogram * 256]
+  int channels = stats.channels;
+  std::vector<jdouble> values(channels * 4 + 256);
+  for (int c = 0; c < channels; c++) {
+    values[c] = stats.sum[c] * stats.scale;
+    values[channels + c] = static_cast<double>(stats.sum[c]) / stats.pixelCount * stats.scale;
+    values[channels * 2 + c] = stats.min[c] * stats.scale;
+    values[channels * 3 + c] = stats.max[c] * stats.scale;
   }
-}
+  std::copy(std::begin(stats.histogram), std::end(stats.histogram), values.begin() + channels * 4);
 
-int FrameBuffer::bytesPerRow() const {
-  size_t bytesPerPixel = getBytesPerPixel(pixelFormat, dataType);
-  return width * bytesPerPixel;
+  local_ref<JArrayDouble> array = JArrayDouble::newArray(values.size());
+  array->setRegion(0, values.size(), values.data());
+  return array;
 }
 
-uint8_t* FrameBuffer::data() const {
-  return buffer->getDirectBytes();
+local_ref<JArrayDouble> ResizePlugin::getStats() {
+  return statsToJavaArray(_stats);
 }
 
-global_ref<JByteBuffer> ResizePlugin::allocateBuffer(size_t size, std::string debugName) {
-  __android_log_print(ANDROID_LOG_INFO, TAG, "Allocating %s Buffer with size %zu...", debugName.c_str(), size);
-  local_ref<JByteBuffer> buffer = JByteBuffer::allocateDirect(size);
-  buffer->order(JByteOrder::nativeOrder());
-  return make_global(buffer);
+local_ref<JArrayDouble> ResizePlugin::getPipelinedStats() {
+  std::unique_lock lock(_workerMutex);
+  return statsToJavaArray(_frontOutput.stats);
 }
 
-FrameBuffer ResizePlugin::imageToFrameBuffer(alias_ref<vision::JImage> image) {
-  jni::local_ref<JArrayClass<JImagePlane>> planes = image->getPlanes();
-
-  int width = image->getWidth();
-  int height = image->getHeight();
-
-  size_t channels = getChannelCount(PixelFormat::ARGB);
-  size_t channelSize = getBytesPerChannel(DataType::UINT8);
-  size_t argbSize = width * height * channels * channelSize;
-  if (_argbBuffer == nullptr || _argbBuffer->getDirectSize() != argbSize) {
-    _argbBuffer = allocateBuffer(argbSize, "_argbBuffer");
+/* Parses the user's 6 (affine) or 9 (perspective) value source -> target matrix, and inverts it into a target -> source matrix */
+void parseTransform(alias_ref<JArrayDouble> transform, int frameWidth, int frameHeight, ResizeOptions& options) {
+  options.hasTransform = transform != nullptr;
+  if (!options.hasTransform) {
+    return;
   }
 
-  FrameBuffer destination = {
-      .width = width,
-      .height = height,
-      .pixelFormat = PixelFormat::ARGB,
-      .dataType = DataType::UINT8,
-      .buffer = _argbBuffer,
-  };
-
-  int sourceImageFormat = image->getFormat();
-  int status;
-
-  switch (sourceImageFormat) {
-    case SourceImageFormat::RGBA_8888: {
-      __android_log_write(ANDROID_LOG_INFO, TAG, "Converting RGBA 8888 -> ARGB 8888...");
-      jni::local_ref<JImagePlane> rgbaPlane = planes->getElement(0);
-      jni::local_ref<JByteBuffer> rgbaBuffer = rgbaPlane->getBuffer();
-      // 1. Convert from RGBA -> ARGB
-      status = libyuv::RGBAToARGB(rgbaBuffer->getDirectBytes(), rgbaPlane->getRowStride(), destination.data(),
-                                  width * channels * channelSize, width, height);
-
-      if (status != 0) {
-        [[unlikely]];
-        throw std::runtime_error("Failed to convert RGBA 8888 to ARGB! Error: " + std::to_string(status));
-      }
-      break;
-    }
-    default: /* SourceImageFormat.YUV_420_888 */
-    {
-      __android_log_write(ANDROID_LOG_INFO, TAG, "Converting YUV 4:2:0 -> ARGB 8888...");
-      jni::local_ref<JImagePlane> yPlane = planes->getElement(0);
-      jni::local_ref<JByteBuffer> yBuffer = yPlane->getBuffer();
-      jni::local_ref<JImagePlane> uPlane = planes->getElement(1);
-      jni::local_ref<JByteBuffer> uBuffer = uPlane->getBuffer();
-      jni::local_ref<JImagePlane> vPlane = planes->getElement(2);
-      jni::local_ref<JByteBuffer> vBuffer = vPlane->getBuffer();
-
-      size_t uvPixelStride = uPlane->getPixelStride();
-      if (uPlane->getPixelStride() != vPlane->getPixelStride()) {
-        [[unlikely]];
-        throw std::runtime_error("U and V planes do not have the same pixel stride! Are you sure this is a 4:2:0 YUV format?");
-      }
-
-      // 1. Convert from YUV -> ARGB
-      status = libyuv::Android420ToARGB(yBuffer->getDirectBytes(), yPlane->getRowStride(), uBuffer->getDirectBytes(),
-                                        uPlane->getRowStride(), vBuffer->getDirectBytes(), vPlane->getRowStride(), uvPixelStride,
-                                        destination.data(), width * channels * channelSize, width, height);
-
-      if (status != 0) {
-        [[unlikely]];
-        throw std::runtime_error("Failed to convert YUV 4:2:0 to ARGB! Error: " + std::to_string(status));
-      }
-      break;
-    }
-  }
-
-  return destination;
-}
-
-std::string rectToString(int x, int y, int width, int height) {
-  return std::to_string(x) + ", " + std::to_string(y) + " @ " + std::to_string(width) + "x" + std::to_string(height);
-}
-
-FrameBuffer ResizePlugin::cropARGBBuffer(const FrameBuffer& frameBuffer, int x, int y, int width, int height) {
-  if (width == frameBuffer.width && height == frameBuffer.height && x == 0 && y == 0) {
-    // already in correct size.
-    return frameBuffer;
+  size_t size = transform->size();
+  if (size != 6 && size != 9) {
+    [[unlikely]];
+    throw std::runtime_error("Transform matrix must have 6 or 9 values! (" + std::to_string(size) + ")");
   }
-
-  auto rectString = rectToString(0, 0, frameBuffer.width, frameBuffer.height);
-  auto targetString = rectToString(x, y, width, height);
-  __android_log_print(ANDROID_LOG_INFO, TAG, "Cropping [%s] ARGB buffer to [%s]...", rectString.c_str(), targetString.c_str());
-
-  size_t channels = getChannelCount(PixelFormat::ARGB);
-  size_t channelSize = getBytesPerChannel(DataType::UINT8);
-  size_t argbSize = width * height * channels * channelSize;
-  if (_cropBuffer == nullptr || _cropBuffer->getDirectSize() != argbSize) {
-    _cropBuffer = allocateBuffer(argbSize, "_cropBuffer");
+  double m[9] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+  transform->getRegion(0, size, m);
+
+  // A homography has no fixed scale, so -H is the same warp as H. Flip it so w is positive at the Frame's center,
+  // only then a negative w means that a point is behind the horizon.
+  double centerW = m[6] * frameWidth / 2.0 + m[7] * frameHeight / 2.0 + m[8];
+  if (centerW < 0.0) {
+    for (int i = 0; i < 9; i++) {
+      m[i] = -m[i];
+    }
   }
-  FrameBuffer destination = {
-      .width = width,
-      .height = height,
-      .pixelFormat = PixelFormat::ARGB,
-      .dataType = DataType::UINT8,
-      .buffer = _cropBuffer,
-  };
 
-  int status = libyuv::ConvertToARGB(frameBuffer.data(), frameBuffer.height * frameBuffer.bytesPerRow(), destination.data(),
-                                     destination.bytesPerRow(), x, y, frameBuffer.width, frameBuffer.height, width, height,
-                                     libyuv::kRotate0, libyuv::FOURCC_ARGB);
-  if (status != 0) {
+  double a = m[4] * m[8] - m[5] * m[7];
+  double b = m[5] * m[6] - m[3] * m[8];
+  double c = m[3] * m[7] - m[4] * m[6];
+  double determinant = m[0] * a + m[1] * b + m[2] * c;
+  if (std::abs(determinant) < 1e-12) {
     [[unlikely]];
-    throw std::runtime_error("Failed to crop ARGB Buffer! Status: " + std::to_string(status));
+    throw std::runtime_error("Transform matrix is not invertible!");
   }
-
-  return destination;
-}
-
-FrameBuffer ResizePlugin::mirrorARGBBuffer(const FrameBuffer& frameBuffer, bool mirror) {
-  if (!mirror) {
-    return frameBuffer;
+  double* inverse = options.transform;
+  inverse[0] = a / determinant;
+  inverse[1] = (m[2] * m[7] - m[1] * m[8]) / determinant;
+  inverse[2] = (m[1] * m[5] - m[2] * m[4]) / determinant;
+  inverse[3] = b / determinant;
+  inverse[4] = (m[0] * m[8] - m[2] * m[6]) / determinant;
+  inverse[5] = (m[2] * m[3] - m[0] * m[5]) / determinant;
+  inverse[6] = c / determinant;
+  inverse[7] = (m[1] * m[6] - m[0] * m[7]) / determinant;
+  inverse[8] = (m[0] * m[4] - m[1] * m[3]) / determinant;
+  // Normalize, so affine matrices take the affine path. This keeps the sign of w, see warpARGBRows.
+  double scale = std::abs(inverse[8]);
+  if (scale != 0.0) {
+    for (int i = 0; i < 9; i++) {
+      inverse[i] /= scale;
+    }
   }
+}
 
-  __android_log_print(ANDROID_LOG_INFO, TAG, "Mirroring ARGB buffer...");
-
-  size_t channels = getChannelCount(PixelFormat::ARGB);
-  size_t channelSize = getBytesPerChannel(DataType::UINT8);
-  size_t argbSize = frameBuffer.width * frameBuffer.height * channels * channelSize;
-  if (_mirrorBuffer == nullptr || _mirrorBuffer->getDirectSize() != argbSize) {
-    _mirrorBuffer = allocateBuffer(argbSize, "_mirrorBuffer");
-  }
-  FrameBuffer destination = {
-      .width = frameBuffer.width,
-      .height = frameBuffer.height,
-      .pixelFormat = PixelFormat::ARGB,
-      .dataType = DataType::UINT8,
-      .buffer = _mirrorBuffer,
+jni::global_ref<jni::JByteBuffer> ResizePlugin::resize(jni::alias_ref<JImage> image, int cropX, int cropY, int cropWidth, int cropHeight,
+                                                       int scaleWidth, int scaleHeight, int /* Rotation */ rotationOrdinal, bool mirror,
+                                                       int /* PixelFormat */ pixelFormatOrdinal, int /* DataType */ dataTypeOrdinal,
+                                                       bool computeStats, jni::alias_ref<JArrayDouble> transform) {
+  ResizeOptions options = {
+      .cropX = cropX,
+      .cropY = cropY,
+      .cropWidth = cropWidth,
+      .cropHeight = cropHeight,
+      .scaleWidth = scaleWidth,
+      .scaleHeight = scaleHeight,
+      .rotation = static_cast<Rotation>(rotationOrdinal),
+      .mirror = mirror,
+      .pixelFormat = static_cast<PixelFormat>(pixelFormatOrdinal),
+      .dataType = static_cast<DataType>(dataTypeOrdinal),
+      .computeStats = computeStats,
   };
+  parseTransform(transform, image->getWidth(), image->getHeight(), options);
 
-  int status = libyuv::ARGBMirror(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
-                                  frameBuffer.width, frameBuffer.height);
-  if (status != 0) {
-    [[unlikely]];
-    throw std::runtime_error("Failed to mirror ARGB Buffer! Status: " + std::to_string(status));
-  }
+  FrameBuffer result = _pipeline.run(getSourceImage(image), options, _stats);
+  return result.buffer;
+}
 
-  return destination;
+bool planesOverlap(const SourcePlane& a, const SourcePlane& b) {
+  return a.data < b.data + b.size && b.data < a.data + a.size;
 }
 
-FrameBuffer ResizePlugin::rotateARGBBuffer(const FrameBuffer& frameBuffer, Rotation rotation) {
-  if (rotation == Rotation::Rotation0) {
-    return frameBuffer;
+void ResizePlugin::copyToPipelinedFrame(const SourceImage& image, PipelinedFrame& frame) {
+  frame.image = image;
+  int planesCount = image.planesCount;
+  if (planesCount == 3 && planesOverlap(image.planes[1], image.planes[2])) {
+    // Interleaved chroma (e.g. NV21): U and V are views into the same memory. Copy it only once and keep their offset,
+    // so libyuv still detects the interleaved layout and takes its fast path.
+    const SourcePlane& uPlane = image.planes[1];
+    const SourcePlane& vPlane = image.planes[2];
+    const uint8_t* begin = std::min(uPlane.data, vPlane.data);
+    const uint8_t* end = std::max(uPlane.data + uPlane.size, vPlane.data + vPlane.size);
+    std::vector<uint8_t>& data = frame.planeData[1];
+    data.resize(end - begin);
+    memcpy(data.data(), begin, end - begin);
+    frame.image.planes[1].data = data.data() + (uPlane.data - begin);
+    frame.image.planes[2].data = data.data() + (vPlane.data - begin);
+    planesCount = 1;
   }
-
-  __android_log_print(ANDROID_LOG_INFO, TAG, "Rotating ARGB buffer by %zu degrees...", static_cast<int>(rotation));
-
-  int rotatedWidth, rotatedHeight;
-  if (rotation == Rotation90 || rotation == Rotation270) {
-    // flipped to the side
-    rotatedWidth = frameBuffer.height;
-    rotatedHeight = frameBuffer.width;
-  } else {
-    // still uprighht, maybe upside down.
-    rotatedWidth = frameBuffer.width;
-    rotatedHeight = frameBuffer.height;
+  for (int i = 0; i < planesCount; i++) {
+    // Only re-allocates if the Frame size changed
+    std::vector<uint8_t>& data = frame.planeData[i];
+    data.resize(image.planes[i].size);
+    memcpy(data.data(), image.planes[i].data, image.planes[i].size);
+    frame.image.planes[i].data = data.data();
   }
+}
 
-  size_t channels = getChannelCount(PixelFormat::ARGB);
-  size_t channelSize = getBytesPerChannel(DataType::UINT8);
-  size_t destinationStride = rotatedWidth * channels * channelSize;
-  size_t rotateSize = frameBuffer.buffer->getDirectSize();
+void ResizePlugin::runPipelinedWorker() {
+  while (true) {
+    std::unique_ptr<PipelinedFrame> frame;
+    {
+      std::unique_lock lock(_workerMutex);
+      _workerCondition.wait(lock, [this] { return !_isWorkerRunning || _pendingFrame != nullptr; });
+      if (!_isWorkerRunning) {
+        return;
+      }
+      frame = std::move(_pendingFrame);
+    }
 
-  if (_rotatedBuffer == nullptr || _rotatedBuffer->getDirectSize() != rotateSize) {
-    _rotatedBuffer = allocateBuffer(rotateSize, "_rotatedBuffer");
-  }
+    try {
+      FrameBuffer result = _workerPipeline.run(frame->image, frame->options, _backOutput.stats);
 
-  FrameBuffer destination = {
-      .width = rotatedWidth,
-      .height = rotatedHeight,
-      .pixelFormat = PixelFormat::ARGB,
-      .dataType = DataType::UINT8,
-      .buffer = _rotatedBuffer,
-  };
+      // Copy the result out of the intermediate buffers so the next Frame can be processed while JS still reads this one
+      size_t size = result.buffer->getDirectSize();
+      if (_backOutput.buffer == nullptr || _backOutput.buffer->getDirectSize() != size) {
+        _backOutput.buffer = ResizePipeline::allocateBuffer(size, "_backOutput");
+      }
+      memcpy(_backOutput.buffer->getDirectBytes(), result.data(), size);
+      _backOutput.timestamp = frame->timestamp;
+      _backOutput.dataType = frame->options.dataType;
+
+      std::unique_lock lock(_workerMutex);
+      std::swap(_backOutput, _readyOutput);
+      _hasReadyOutput = true;
+    } catch (const std::exception& exception) {
+      __android_log_print(ANDROID_LOG_ERROR, TAG, "Failed to resize pipelined Frame! %s", exception.what());
+    }
 
-  libyuv::RotationMode rotationMode = getRotationModeForRotation(rotation);
-  int status = libyuv::ARGBRotate(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destinationStride, frameBuffer.width,
-                                  frameBuffer.height, rotationMode);
-  if (status != 0) {
-    [[unlikely]];
-    throw std::runtime_error("Failed to rotate ARGB Buffer! Status: " + std::to_string(status));
+    std::unique_lock lock(_workerMutex);
+    if (_spareFrame == nullptr) {
+      // Keep the allocation around for the next Frame
+      _spareFrame = std::move(frame);
+    }
   }
-
-  return destination;
 }
 
-FrameBuffer ResizePlugin::scaleARGBBuffer(const FrameBuffer& frameBuffer, int width, int height) {
-  if (width == frameBuffer.width && height == frameBuffer.height) {
-    // already in correct size.
-    return frameBuffer;
-  }
-  auto rectString = rectToString(0, 0, frameBuffer.width, frameBuffer.height);
-  auto targetString = rectToString(0, 0, width, height);
-  __android_log_print(ANDROID_LOG_INFO, TAG, "Scaling [%s] ARGB buffer to [%s]...", rectString.c_str(), targetString.c_str());
-
-  size_t channels = getChannelCount(PixelFormat::ARGB);
-  size_t channelSize = getBytesPerChannel(DataType::UINT8);
-  size_t argbSize = width * height * channels * channelSize;
-  if (_scaleBuffer == nullptr || _scaleBuffer->getDirectSize() != argbSize) {
-    _scaleBuffer = allocateBuffer(argbSize, "_scaleBuffer");
-  }
-  FrameBuffer destination = {
-      .width = width,
-      .height = height,
-      .pixelFormat = PixelFormat::ARGB,
-      .dataType = DataType::UINT8,
-      .buffer = _scaleBuffer,
-  };
-
-  int status = libyuv::ARGBScale(frameBuffer.data(), frameBuffer.bytesPerRow(), frameBuffer.width, frameBuffer.height, destination.data(),
-                                 destination.bytesPerRow(), width, height, libyuv::FilterMode::kFilterBilinear);
-  if (status != 0) {
-    [[unlikely]];
-    throw std::runtime_error("Failed to scale ARGB Buffer! Status: " + std::to_string(status));
+jni::global_ref<jni::JByteBuffer> ResizePlugin::resizePipelined(jni::alias_ref<JImage> image, jlong timestamp, int cropX, int cropY,
+                                                                int cropWidth, int cropHeight, int scaleWidth, int scaleHeight,
+                                                                int /* Rotation */ rotationOrdinal, bool mirror,
+                                                                int /* PixelFormat */ pixelFormatOrdinal,
+                                                                int /* DataType */ dataTypeOrdinal, bool computeStats,
+                                                                jni::alias_ref<JArrayDouble> transform) {
+  std::unique_ptr<PipelinedFrame> frame;
+  {
+    std::unique_lock lock(_workerMutex);
+    if (!_isWorkerRunning) {
+      __android_log_write(ANDROID_LOG_INFO, TAG, "Starting pipelined resize worker...");
+      _isWorkerRunning = true;
+      _workerThread = std::thread([this] { ThreadScope::WithClassLoader([this] { runPipelinedWorker(); }); });
+    }
+    frame = std::move(_spareFrame);
   }
-
-  return destination;
-}
-
-FrameBuffer ResizePlugin::convertARGBBufferTo(const FrameBuffer& frameBuffer, PixelFormat pixelFormat) {
-  if (frameBuffer.pixelFormat == pixelFormat) {
-    // Already in the correct format.
-    return frameBuffer;
+  if (frame == nullptr) {
+    frame = std::make_unique<PipelinedFrame>();
   }
 
-  __android_log_print(ANDROID_LOG_INFO, TAG, "Converting ARGB Buffer to Pixel Format %zu...", pixelFormat);
-
-  size_t bytesPerPixel = getBytesPerPixel(pixelFormat, frameBuffer.dataType);
-  size_t targetBufferSize = frameBuffer.width * frameBuffer.height * bytesPerPixel;
-  if (_customFormatBuffer == nullptr || _customFormatBuffer->getDirectSize() != targetBufferSize) {
-    _customFormatBuffer = allocateBuffer(targetBufferSize, "_customFormatBuffer");
-  }
-  FrameBuffer destination = {
-      .width = frameBuffer.width,
-      .height = frameBuffer.height,
-      .pixelFormat = pixelFormat,
-      .dataType = frameBuffer.dataType,
-      .buffer = _customFormatBuffer,
+  // 1. Copy the planes, the Image will be closed once the Frame Processor returns
+  copyToPipelinedFrame(getSourceImage(image), *frame);
+  frame->timestamp = timestamp;
+  frame->options = {
+      .cropX = cropX,
+      .cropY = cropY,
+      .cropWidth = cropWidth,
+      .cropHeight = cropHeight,
+      .scaleWidth = scaleWidth,
+      .scaleHeight = scaleHeight,
+      .rotation = static_cast<Rotation>(rotationOrdinal),
+      .mirror = mirror,
+      .pixelFormat = static_cast<PixelFormat>(pixelFormatOrdinal),
+      .dataType = static_cast<DataType>(dataTypeOrdinal),
+      .computeStats = computeStats,
   };
+  parseTransform(transform, frame->image.width, frame->image.height, frame->options);
 
-  int error = 0;
-  switch (pixelFormat) {
-    case PixelFormat::ARGB:
-      // do nothing, we're already in ARGB
-      return frameBuffer;
-    case RGB:
-      // RAW is [R, G, B] in libyuv memory layout
-      error = libyuv::ARGBToRAW(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
-                                destination.width, destination.height);
-      break;
-    case BGR:
-      // RGB24 is [B, G, R] in libyuv memory layout
-      error = libyuv::ARGBToRGB24(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
-                                  destination.width, destination.height);
-      break;
-    case RGBA:
-      error = libyuv::ARGBToRGBA(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
-                                 destination.width, destination.height);
-      break;
-    case BGRA:
-      error = libyuv::ARGBToBGRA(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
-                                 destination.width, destination.height);
-      break;
-    case ABGR:
-      error = libyuv::ARGBToABGR(frameBuffer.data(), frameBuffer.bytesPerRow(), destination.data(), destination.bytesPerRow(),
-                                 destination.width, destination.height);
-      break;
+  std::unique_lock lock(_workerMutex);
+  // 2. Hand it to the worker. If it is still busy with an older Frame that has not been picked up yet, that one gets dropped.
+  if (_pendingFrame != nullptr && _spareFrame == nullptr) {
+    _spareFrame = std::move(_pendingFrame);
   }
+  _pendingFrame = std::move(frame);
+  _workerCondition.notify_one();
 
-  if (error != 0) {
-    [[unlikely]];
-    throw std::runtime_error("Failed to convert ARGB Buffer to target Pixel Format! Error: " + std::to_string(error));
+  // 3. Return the most recently completed result, if any
+  if (_hasReadyOutput) {
+    std::swap(_frontOutput, _readyOutput);
+    _hasReadyOutput = false;
   }
-
-  return destination;
+  return _frontOutput.buffer;
 }
 
-FrameBuffer ResizePlugin::convertBufferToDataType(const FrameBuffer& frameBuffer, DataType dataType) {
-  if (frameBuffer.dataType == dataType) {
-    // Already in correct data-type
-    return frameBuffer;
-  }
-
-  __android_log_print(ANDROID_LOG_INFO, TAG, "Converting ARGB Buffer to Data Type %zu...", dataType);
+jlong ResizePlugin::getPipelinedTimestamp() {
+  std::unique_lock lock(_workerMutex);
+  return _frontOutput.timestamp;
+}
 
-  size_t targetSize = frameBuffer.width * frameBuffer.height * getBytesPerPixel(frameBuffer.pixelFormat, dataType);
-  if (_customTypeBuffer == nullptr || _customTypeBuffer->getDirectSize() != targetSize) {
-    _customTypeBuffer = allocateBuffer(targetSize, "_customTypeBuffer");
-  }
-  size_t size = frameBuffer.buffer->getDirectSize();
-  FrameBuffer destination = {
-      .width = frameBuffer.width,
-      .height = frameBuffer.height,
-      .pixelFormat = frameBuffer.pixelFormat,
-      .dataType = dataType,
-      .buffer = _customTypeBuffer,
-  };
+int ResizePlugin::getPipelinedDataType() {
+  std::unique_lock lock(_workerMutex);
+  return static_cast<int>(_frontOutput.dataType);
+}
 
-  int status = 0;
-  switch (dataType) {
-    case UINT8:
-      // it's already uint8
-      return frameBuffer;
-    case FLOAT32: {
-      float* floatData = reinterpret_cast<float*>(destination.data());
-      status = libyuv::ByteToFloat(frameBuffer.data(), floatData, 1.0f / 255.0f, size);
-      break;
-    }
+ResizePlugin::~ResizePlugin() {
+  {
+    std::unique_lock lock(_workerMutex);
+    _isWorkerRunning = false;
   }
-
-  if (status != 0) {
-    [[unlikely]];
-    throw std::runtime_error("Failed to convert Buffer to target Data Type! Error: " + std::to_string(status));
+  _workerCondition.notify_one();
+  if (_workerThread.joinable()) {
+    _workerThread.join();
   }
-
-  return destination;
-}
-
-jni::global_ref<jni::JByteBuffer> ResizePlugin::resize(jni::alias_ref<JImage> image, int cropX, int cropY, int cropWidth, int cropHeight,
-                                                       int scaleWidth, int scaleHeight, int /* Rotation */ rotationOrdinal, bool mirror,
-                                                       int /* PixelFormat */ pixelFormatOrdinal, int /* DataType */ dataTypeOrdinal) {
-  PixelFormat pixelFormat = static_cast<PixelFormat>(pixelFormatOrdinal);
-  DataType dataType = static_cast<DataType>(dataTypeOrdinal);
-  Rotation rotation = static_cast<Rotation>(rotationOrdinal);
-
-  // 1. Convert from YUV/RGBA -> ARGB
-  FrameBuffer result = imageToFrameBuffer(image);
-
-  // 2. Crop ARGB
-  result = cropARGBBuffer(result, cropX, cropY, cropWidth, cropHeight);
-
-  // 3. Scale ARGB
-  result = scaleARGBBuffer(result, scaleWidth, scaleHeight);
-
-  // 4. Rotate ARGB
-  result = rotateARGBBuffer(result, rotation);
-
-  // 5 Mirror ARGB if needed
-  result = mirrorARGBBuffer(result, mirror);
-
-  // 6. Convert from ARGB -> ????
-  result = convertARGBBufferTo(result, pixelFormat);
-
-  // 7. Convert from data type to other data type
-  result = convertBufferToDataType(result, dataType);
-
-  return result.buffer;
 }
 
 jni::local_ref<ResizePlugin::jhybriddata> ResizePlugin::initHybrid(jni::alias_ref<jhybridobject> javaThis) {
@@ -6,73 +6,82 @@
 
 #include <fbjni/ByteBuffer.h>
 #include <fbjni/fbjni.h>
+#include <condition_variable>
 #include <jni.h>
 #include <memory>
-#include <string>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "JImage.h"
+#include "ResizePipeline.h"
 
 namespace vision {
 
 using namespace facebook;
 using namespace jni;
 
-enum PixelFormat { RGB, BGR, ARGB, RGBA, BGRA, ABGR };
-
-/* Those should match Android ImageFormat and PixelFormat constants */
-enum SourceImageFormat { RGBA_8888 = 1, YUV_420_888 = 35 };
-
-enum DataType { UINT8, FLOAT32 };
-
-enum Rotation { Rotation0 = 0, Rotation90 = 90, Rotation180 = 180, Rotation270 = 270 };
+/* A deep copy of a Frame, so it can be processed after the Image has been closed */
+struct PipelinedFrame {
+  SourceImage image;
+  std::vector<uint8_t> planeData[3];
+  ResizeOptions options;
+  int64_t timestamp;
+};
 
-struct FrameBuffer {
-  int width;
-  int height;
-  PixelFormat pixelFormat;
-  DataType dataType;
+struct PipelinedOutput {
   global_ref<JByteBuffer> buffer;
-
-  uint8_t* data() const;
-  int bytesPerRow() const;
+  int64_t timestamp;
+  DataType dataType;
+  FrameStats stats = {};
 };
 
 struct ResizePlugin : public HybridClass<ResizePlugin> {
 public:
   static auto constexpr kJavaDescriptor = "Lcom/visioncameraresizeplugin/ResizePlugin;";
   static void registerNatives();
+  ~ResizePlugin();
 
 private:
   explicit ResizePlugin(const alias_ref<jhybridobject>& javaThis);
 
   global_ref<JByteBuffer> resize(alias_ref<JImage> image, int cropX, int cropY, int cropWidth, int cropHeight, int scaleWidth,
                                  int scaleHeight, int /* Rotation */ rotation, bool mirror, int /* PixelFormat */ pixelFormat,
-                                 int /* DataType */ dataType);
-
-  FrameBuffer imageToFrameBuffer(alias_ref<JImage> image);
-  FrameBuffer cropARGBBuffer(const FrameBuffer& frameBuffer, int x, int y, int width, int height);
-  FrameBuffer scaleARGBBuffer(const FrameBuffer& frameBuffer, int width, int height);
-  FrameBuffer convertARGBBufferTo(const FrameBuffer& frameBuffer, PixelFormat toFormat);
-  FrameBuffer convertBufferToDataType(const FrameBuffer& frameBuffer, DataType dataType);
-  FrameBuffer rotateARGBBuffer(const FrameBuffer& frameBuffer, Rotation rotation);
-  FrameBuffer mirrorARGBBuffer(const FrameBuffer& frameBuffer, bool mirror);
-  global_ref<JByteBuffer> allocateBuffer(size_t size, std::string debugName);
+                                 int /* DataType */ dataType, bool computeStats, alias_ref<JArrayDouble> transform);
+  global_ref<JByteBuffer> resizePipelined(alias_ref<JImage> image, jlong timestamp, int cropX, int cropY, int cropWidth, int cropHeight,
+                                          int scaleWidth, int scaleHeight, int /* Rotation */ rotation, bool mirror,
+                                          int /* PixelFormat */ pixelFormat, int /* DataType */ dataType, bool computeStats,
+                                          alias_ref<JArrayDouble> transform);
+  jlong getPipelinedTimestamp();
+  int /* DataType */ getPipelinedDataType();
+  local_ref<JArrayDouble> getStats();
+  local_ref<JArrayDouble> getPipelinedStats();
+
+  SourceImage getSourceImage(alias_ref<JImage> image);
+  void copyToPipelinedFrame(const SourceImage& image, PipelinedFrame& frame);
+  void runPipelinedWorker();
 
 private:
   static auto constexpr TAG = "ResizePlugin";
   friend HybridBase;
   global_ref<javaobject> _javaThis;
-  // YUV (?x?) -> ARGB (?x?)
-  global_ref<JByteBuffer> _argbBuffer;
-  // ARGB (?x?) -> ARGB (!x!)
-  global_ref<JByteBuffer> _cropBuffer;
-  global_ref<JByteBuffer> _scaleBuffer;
-  global_ref<JByteBuffer> _rotatedBuffer;
-  global_ref<JByteBuffer> _mirrorBuffer;
-  // ARGB (?x?) -> !!!! (?x?)
-  global_ref<JByteBuffer> _customFormatBuffer;
-  // Custom Data Type (e.g. float32)
-  global_ref<JByteBuffer> _customTypeBuffer;
+  // Used by resize() on the Frame Processor Thread
+  ResizePipeline _pipeline;
+  // Stats of the last synchronous resize, if requested
+  FrameStats _stats = {};
+  // Pipelined mode: Frames are copied and processed on _workerThread, which has its own intermediate buffers
+  ResizePipeline _workerPipeline;
+  std::thread _workerThread;
+  std::mutex _workerMutex;
+  std::condition_variable _workerCondition;
+  bool _isWorkerRunning = false;
+  std::unique_ptr<PipelinedFrame> _pendingFrame;
+  std::unique_ptr<PipelinedFrame> _spareFrame;
+  // _backOutput is written by the worker, _readyOutput is the latest completed result, _frontOutput is owned by JS
+  PipelinedOutput _backOutput;
+  PipelinedOutput _readyOutput;
+  PipelinedOutput _frontOutput;
+  bool _hasReadyOutput = false;
 
   static local_ref<jhybriddata> initHybrid(alias_ref<jhybridobject> javaThis);
 };
@@ -43,10 +43,32 @@ class ResizePlugin(private val proxy: VisionCameraProxy) : FrameProcessorPlugin(
     rotation: Int,
     mirror: Boolean,
     pixelFormat: Int,
-    dataType: Int
+    dataType: Int,
+    computeStats: Boolean,
+    transform: DoubleArray?
   ): ByteBuffer
+  private external fun resizePipelined(
+    image: Image,
+    timestamp: Long,
+    cropX: Int,
+    cropY: Int,
+    cropWidth: Int,
+    cropHeight: Int,
+    scaleWidth: Int,
+    scaleHeight: Int,
+    rotation: Int,
+    mirror: Boolean,
+    pixelFormat: Int,
+    dataType: Int,
+    computeStats: Boolean,
+    transform: DoubleArray?
+  ): ByteBuffer?
+  private external fun getPipelinedTimestamp(): Long
+  private external fun getPipelinedDataType(): Int
+  private external fun getStats(): DoubleArray?
+  private external fun getPipelinedStats(): DoubleArray?
 
-  override fun callback(frame: Frame, params: MutableMap<String, Any>?): Any {
+  override fun callback(frame: Frame, params: MutableMap<String, Any>?): Any? {
     if (params == null) {
       throw Error("Options cannot be null!")
     }
@@ -93,8 +115,23 @@ class ResizePlugin(private val proxy: VisionCameraProxy) : FrameProcessorPlugin(
       Log.i(TAG, "Target scale: $scaleWidth x $scaleHeight")
     }
 
+    var transformMatrix: DoubleArray? = null
+    val transform = params["transform"] as? Map<*, *>
+    if (transform != null) {
+      val matrix = transform["matrix"] as? List<*>
+      if (matrix == null || (matrix.size != 6 && matrix.size != 9)) {
+        throw Error("Transform matrix must have 6 or 9 values!")
+      }
+      transformMatrix = DoubleArray(matrix.size) { i ->
+        (matrix[i] as? Number)?.toDouble() ?: throw Error("Failed to parse values in transform matrix!")
+      }
+      Log.i(TAG, "Transform: ${transformMatrix.joinToString()}")
+    }
+
     val crop = params["crop"] as? Map<*, *>
-    if (crop != null) {
+    if (transformMatrix != null) {
+      Log.i(TAG, "Transform is set, crop will be ignored.")
+    } else if (crop != null) {
       val cropWidthDouble = crop["width"] as? Double
       val cropHeightDouble = crop["height"] as? Double
       val cropXDouble = crop["x"] as? Double
@@ -140,6 +177,14 @@ class ResizePlugin(private val proxy: VisionCameraProxy) : FrameProcessorPlugin(
       Log.i(TAG, "Target DataType: $targetType")
     }
 
+    val statsParam = params["stats"]
+    val computeStats = statsParam is Boolean && statsParam
+    Log.i(TAG, "Stats: $computeStats")
+
+    val pipelinedParam = params["pipelined"]
+    val pipelined = pipelinedParam is Boolean && pipelinedParam
+    Log.i(TAG, "Pipelined: $pipelined")
+
     val image = frame.image
 
     if (image.format != ImageFormat.YUV_420_888 && image.format != AndroidPixelFormat.RGBA_8888) {
@@ -151,6 +196,30 @@ class ResizePlugin(private val proxy: VisionCameraProxy) : FrameProcessorPlugin(
       )
     }
 
+    if (pipelined) {
+      val completed = resizePipelined(
+        image,
+        frame.timestamp,
+        cropX, cropY,
+        cropWidth, cropHeight,
+        scaleWidth, scaleHeight,
+        rotation.degrees,
+        mirror,
+        targetFormat.ordinal,
+        targetType.ordinal,
+        computeStats,
+        transformMatrix
+      ) ?: return null
+
+      val result = mutableMapOf<String, Any>(
+        "buffer" to SharedArray(proxy, completed),
+        "timestamp" to getPipelinedTimestamp().toDouble(),
+        "dataType" to DataType.values()[getPipelinedDataType()].jsValue
+      )
+      getPipelinedStats()?.let { result["stats"] = statsToMap(it) }
+      return result
+    }
+
     val resized = resize(
       image,
       cropX, cropY,
@@ -159,12 +228,34 @@ class ResizePlugin(private val proxy: VisionCameraProxy) : FrameProcessorPlugin(
       rotation.degrees,
       mirror,
       targetFormat.ordinal,
-      targetType.ordinal
+      targetType.ordinal,
+      computeStats,
+      transformMatrix
     )
 
+    if (computeStats) {
+      val stats = getStats() ?: throw Error("Failed to compute stats!")
+      return mapOf(
+        "buffer" to SharedArray(proxy, resized),
+        "stats" to statsToMap(stats)
+      )
+    }
+
     return SharedArray(proxy, resized)
   }
 
+  private fun statsToMap(stats: DoubleArray): Map<String, Any> {
+    // Layout is [sum * channels, mean * channels, min * channels, max * channels, histogram * 256], see ResizePlugin.cpp
+    val channels = (stats.size - 256) / 4
+    return mapOf(
+      "sum" to stats.slice(0 until channels),
+      "mean" to stats.slice(channels until channels * 2),
+      "min" to stats.slice(channels * 2 until channels * 3),
+      "max" to stats.slice(channels * 3 until channels * 4),
+      "histogram" to stats.slice(channels * 4 until stats.size)
+    )
+  }
+
   private enum class PixelFormat {
     // Integer-Values (ordinals) to be in sync with ResizePlugin.h
     RGB,
@@ -188,10 +279,10 @@ class ResizePlugin(private val proxy: VisionCameraProxy) : FrameProcessorPlugin(
     }
   }
 
-  private enum class DataType {
+  private enum class DataType(val jsValue: String) {
     // Integer-Values (ordinals) to be in sync with ResizePlugin.h
-    UINT8,
-    FLOAT32;
+    UINT8("uint8"),
+    FLOAT32("float32");
 
     companion object {
       fun fromString(string: String): DataType =
@@ -21,11 +21,12 @@ typedef NS_ENUM(NSInteger, ConvertDataType) { UINT8, FLOAT32 };
 
 @interface FrameBuffer : NSObject
 
+// If proxy is nil, the buffer is backed by plain memory and has no sharedArray. Use this for buffers created outside of the JS Thread.
 - (instancetype)initWithWidth:(size_t)width
                        height:(size_t)height
                   pixelFormat:(ConvertPixelFormat)pixelFormat
                      dataType:(ConvertDataType)dataType
-                        proxy:(VisionCameraProxyHolder*)proxy;
+                        proxy:(nullable VisionCameraProxyHolder*)proxy;
 
 @property(nonatomic, readonly) size_t width;
 @property(nonatomic, readonly) size_t height;
@@ -37,7 +38,7 @@ typedef NS_ENUM(NSInteger, ConvertDataType) { UINT8, FLOAT32 };
 @property(nonatomic, readonly) size_t bytesPerPixel;
 
 @property(nonatomic, readonly, nonnull) const vImage_Buffer* imageBuffer;
-@property(nonatomic, readonly, nonnull) SharedArray* sharedArray;
+@property(nonatomic, readonly, nullable) SharedArray* sharedArray;
 
 + (size_t)getBytesForDataType:(ConvertDataType)type;
 + (size_t)getChannelsPerPixelForFormat:(ConvertPixelFormat)format;
@@ -15,6 +15,7 @@
 @implementation FrameBuffer {
   vImage_Buffer _imageBuffer;
   SharedArray* _sharedArray;
+  void* _data;
 }
 
 - (instancetype)initWithWidth:(size_t)width
@@ -30,13 +31,25 @@
 
     size_t bytesPerPixel = [FrameBuffer getBytesPerPixel:pixelFormat withType:dataType];
     size_t size = width * height * bytesPerPixel;
-    NSLog(@"Allocating SharedArray (size: %zu)...", size);
-    _sharedArray = [[SharedArray alloc] initWithProxy:proxy allocateWithSize:size];
-    _imageBuffer = vImage_Buffer{.width = width, .height = height, .data = _sharedArray.data, .rowBytes = width * bytesPerPixel};
+    void* data;
+    if (proxy != nil) {
+      NSLog(@"Allocating SharedArray (size: %zu)...", size);
+      _sharedArray = [[SharedArray alloc] initWithProxy:proxy allocateWithSize:size];
+      data = _sharedArray.data;
+    } else {
+      NSLog(@"Allocating plain buffer (size: %zu)...", size);
+      _data = malloc(size);
+      data = _data;
+    }
+    _imageBuffer = vImage_Buffer{.width = width, .height = height, .data = data, .rowBytes = width * bytesPerPixel};
   }
   return self;
 }
 
+- (void)dealloc {
+  free(_data);
+}
+
 @synthesize width = _width;
 @synthesize height = _height;
 @synthesize pixelFormat = _pixelFormat;
@@ -0,0 +1,67 @@
+//
+//  ResizePipeline.h
+//  VisionCameraResizePlugin
+//
+//  Created by Marc Rousavy on 23.09.23.
+//  Copyright © 2023 Facebook. All rights reserved.
+//
+
+#pragma once
+
+#import <Accelerate/Accelerate.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import <Foundation/Foundation.h>
+#import <VisionCamera/VisionCameraProxyHolder.h>
+
+#import "FrameBuffer.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, Rotation) { Rotation0 = 0, Rotation90 = 90, Rotation180 = 180, Rotation270 = 270 };
+
+typedef struct {
+  CGRect crop;
+  CGSize scale;
+  Rotation rotation;
+  BOOL mirror;
+  ConvertPixelFormat pixelFormat;
+  ConvertDataType dataType;
+  BOOL computeStats;
+  // If set, crop and scale are replaced by sampling with this row-major 3x3 matrix (target -> source pixel coordinates)
+  BOOL hasTransform;
+  double transform[9];
+} ResizeOptions;
+
+// The planes of a Frame. They either point into a locked CVPixelBuffer, or into memory owned by the caller.
+typedef struct {
+  OSType pixelFormat;
+  size_t width;
+  size_t height;
+  size_t planesCount;
+  vImage_Buffer planes[2];
+} SourceImage;
+
+// Statistics of the resulting buffer, accumulated while converting it to the target data type
+typedef struct {
+  BOOL isValid;
+  size_t channels;
+  size_t pixelCount;
+  // Converts uint8 values to the range of the target data type
+  float scale;
+  uint64_t sum[4];
+  uint8_t min[4];
+  uint8_t max[4];
+  uint32_t histogram[256];
+} FrameStats;
+
+// Runs all conversion steps on a Frame. Owns the intermediate buffers, so it must only be used from one thread at a time.
+@interface ResizePipeline : NSObject
+
+// If proxy is nil, all buffers are plain memory without a SharedArray, so the pipeline can run outside of the JS Thread.
+- (instancetype)initWithProxy:(nullable VisionCameraProxyHolder*)proxy;
+
+- (FrameBuffer*)run:(SourceImage)image options:(ResizeOptions)options stats:(FrameStats*)stats;
+
+@end
+
+NS_ASSUME_NONNULL_END
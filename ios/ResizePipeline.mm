@@ -0,0 +1,666 @@
+//
+//  ResizePipeline.mm
+//  VisionCameraResizePlugin
+//
+//  Created by Marc Rousavy on 23.09.23.
+//  Copyright © 2023 Facebook. All rights reserved.
+//
+
+#import "ResizePipeline.h"
+#import "FrameBuffer.h"
+
+#import <Accelerate/Accelerate.h>
+#import <UIKit/UIKit.h>
+#import <algorithm>
+
+#define AdvancePtr(_ptr, _bytes) (__typeof__(_ptr))((uintptr_t)(_ptr) + (size_t)(_bytes))
+
+void getRGBOffsets(ConvertPixelFormat pixelFormat, size_t* r, size_t* g, size_t* b) {
+  switch (pixelFormat) {
+    case RGB:
+    case RGBA:
+      *r = 0, *g = 1, *b = 2;
+      break;
+    case BGR:
+    case BGRA:
+      *r = 2, *g = 1, *b = 0;
+      break;
+    case ARGB:
+      *r = 1, *g = 2, *b = 3;
+      break;
+    case ABGR:
+      *r = 3, *g = 2, *b = 1;
+      break;
+  }
+}
+
+template <bool WriteFloat> void accumulateStats(FrameBuffer* buffer, float* floatOutput, FrameStats* stats) {
+  size_t channels = buffer.channelsPerPixel;
+  size_t pixelCount = buffer.width * buffer.height;
+  size_t r, g, b;
+  getRGBOffsets(buffer.pixelFormat, &r, &g, &b);
+
+  uint64_t sum[4] = {0, 0, 0, 0};
+  uint8_t min[4] = {255, 255, 255, 255};
+  uint8_t max[4] = {0, 0, 0, 0};
+  uint32_t histogram[256] = {0};
+
+  const uint8_t* pixel = (const uint8_t*)buffer.imageBuffer->data;
+  for (size_t i = 0; i < pixelCount; i++, pixel += channels) {
+    for (size_t c = 0; c < channels; c++) {
+      uint8_t value = pixel[c];
+      sum[c] += value;
+      min[c] = std::min(min[c], value);
+      max[c] = std::max(max[c], value);
+      if constexpr (WriteFloat) {
+        floatOutput[i * channels + c] = value * (1.0f / 255.0f);
+      }
+    }
+    // BT.601 luma in 8-bit fixed point, weights sum up to 256
+    uint32_t luma = (77 * pixel[r] + 150 * pixel[g] + 29 * pixel[b]) >> 8;
+    histogram[luma]++;
+  }
+
+  stats->isValid = YES;
+  stats->channels = channels;
+  stats->pixelCount = pixelCount;
+  std::copy(std::begin(sum), std::end(sum), stats->sum);
+  std::copy(std::begin(min), std::end(min), stats->min);
+  std::copy(std::begin(max), std::end(max), stats->max);
+  std::copy(std::begin(histogram), std::end(histogram), stats->histogram);
+}
+
+// Blends two ARGB pixels by f / 256 towards b, with two channels per 32-bit multiply instead of one multiply per channel
+inline uint32_t lerpARGB(uint32_t a, uint32_t b, uint32_t f) {
+  uint32_t rb = (((a & 0x00FF00FF) * (256 - f) + (b & 0x00FF00FF) * f + 0x00800080) >> 8) & 0x00FF00FF;
+  uint32_t ag = (((a >> 8) & 0x00FF00FF) * (256 - f) + ((b >> 8) & 0x00FF00FF) * f + 0x00800080) & 0xFF00FF00;
+  return rb | ag;
+}
+
+inline uint32_t loadARGB(const uint8_t* pixel) {
+  uint32_t value;
+  memcpy(&value, pixel, 4);
+  return value;
+}
+
+// Bilinearly samples the 4 channels at the given 24.8 fixed-point source position, or returns 0 if it is outside of the source
+inline uint32_t sampleBilinear(const vImage_Buffer* source, int32_t fixedX, int32_t fixedY) {
+  int srcWidth = (int)source->width;
+  int srcHeight = (int)source->height;
+  int x0 = fixedX >> 8;
+  int y0 = fixedY >> 8;
+  if (x0 < -1 || y0 < -1 || x0 >= srcWidth || y0 >= srcHeight) {
+    return 0;
+  }
+  // Clamp to the edges so the border pixels blend with themselves
+  int x1 = std::min(x0 + 1, srcWidth - 1);
+  int y1 = std::min(y0 + 1, srcHeight - 1);
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+
+  const uint8_t* row0 = AdvancePtr((const uint8_t*)source->data, y0 * source->rowBytes);
+  const uint8_t* row1 = AdvancePtr((const uint8_t*)source->data, y1 * source->rowBytes);
+  uint32_t top = lerpARGB(loadARGB(row0 + x0 * 4), loadARGB(row0 + x1 * 4), fixedX & 0xFF);
+  uint32_t bottom = lerpARGB(loadARGB(row1 + x0 * 4), loadARGB(row1 + x1 * 4), fixedX & 0xFF);
+  return lerpARGB(top, bottom, fixedY & 0xFF);
+}
+
+inline int64_t floorDiv(int64_t a, int64_t b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Narrows [begin, end) to the x for which lo <= start + x * step <= hi
+inline void narrowSpan(int64_t start, int64_t step, int64_t lo, int64_t hi, int64_t& begin, int64_t& end) {
+  if (step < 0) {
+    narrowSpan(-start, -step, -hi, -lo, begin, end);
+  } else if (step == 0) {
+    if (start < lo || start > hi) {
+      end = begin;
+    }
+  } else {
+    begin = std::max(begin, -floorDiv(start - lo, step));
+    end = std::min(end, floorDiv(hi - start, step) + 1);
+  }
+}
+
+constexpr double kMinPerspectiveW = 1e-9;
+
+// Samples every target pixel from the source. Source coordinates are advanced incrementally per row instead of multiplying per pixel.
+template <bool Perspective> void warpARGBRows(const vImage_Buffer* source, const vImage_Buffer* destination, const double m[9]) {
+  int width = (int)destination->width;
+  for (size_t y = 0; y < destination->height; y++) {
+    uint32_t* row = AdvancePtr((uint32_t*)destination->data, y * destination->rowBytes);
+    // Map pixel centers, and shift back by half a pixel for sampling
+    double u = m[0] * 0.5 + m[1] * (y + 0.5) + m[2];
+    double v = m[3] * 0.5 + m[4] * (y + 0.5) + m[5];
+    if constexpr (Perspective) {
+      double w = m[6] * 0.5 + m[7] * (y + 0.5) + m[8];
+      for (int x = 0; x < width; x++, u += m[0], v += m[3], w += m[6]) {
+        if (w <= kMinPerspectiveW) {
+          // Behind the camera (or at infinity), dividing by w would produce Inf/NaN
+          row[x] = 0;
+          continue;
+        }
+        double sourceX = u / w - 0.5;
+        double sourceY = v / w - 0.5;
+        // Clamp before converting to fixed-point, anything out there is outside of the source anyways
+        int32_t fixedX = (int32_t)(std::clamp(sourceX, -2.0, 1e6) * 256.0);
+        int32_t fixedY = (int32_t)(std::clamp(sourceY, -2.0, 1e6) * 256.0);
+        row[x] = sampleBilinear(source, fixedX, fixedY);
+      }
+    } else {
+      // 16.16 fixed-point, so each step is a single integer add
+      int64_t startX = (int64_t)((u - 0.5) * 65536.0);
+      int64_t startY = (int64_t)((v - 0.5) * 65536.0);
+      int64_t stepX = (int64_t)(m[0] * 65536.0);
+      int64_t stepY = (int64_t)(m[3] * 65536.0);
+
+      // Pixels whose 2x2 neighbourhood is fully inside of the source don't need any bounds checks
+      int64_t interiorBegin = 0;
+      int64_t interiorEnd = width;
+      narrowSpan(startX, stepX, 0, ((int64_t)(source->width - 1) << 16) - 1, interiorBegin, interiorEnd);
+      narrowSpan(startY, stepY, 0, ((int64_t)(source->height - 1) << 16) - 1, interiorBegin, interiorEnd);
+      int begin = (int)std::min<int64_t>(interiorBegin, width);
+      int end = (int)std::clamp<int64_t>(interiorEnd, begin, width);
+
+      auto sampleEdge = [&](int x) {
+        int64_t fixedX = startX + x * stepX;
+        int64_t fixedY = startY + x * stepY;
+        int32_t sampleX = (int32_t)std::clamp<int64_t>(fixedX >> 8, -512, 1 << 30);
+        int32_t sampleY = (int32_t)std::clamp<int64_t>(fixedY >> 8, -512, 1 << 30);
+        row[x] = sampleBilinear(source, sampleX, sampleY);
+      };
+      for (int x = 0; x < begin; x++) {
+        sampleEdge(x);
+      }
+      const uint8_t* src = (const uint8_t*)source->data;
+      int64_t fixedX = startX + begin * stepX;
+      int64_t fixedY = startY + begin * stepY;
+      for (int x = begin; x < end; x++, fixedX += stepX, fixedY += stepY) {
+        const uint8_t* row0 = src + (fixedY >> 16) * source->rowBytes + (fixedX >> 16) * 4;
+        const uint8_t* row1 = row0 + source->rowBytes;
+        uint32_t fx = (fixedX >> 8) & 0xFF;
+        uint32_t top = lerpARGB(loadARGB(row0), loadARGB(row0 + 4), fx);
+        uint32_t bottom = lerpARGB(loadARGB(row1), loadARGB(row1 + 4), fx);
+        row[x] = lerpARGB(top, bottom, (fixedY >> 8) & 0xFF);
+      }
+      for (int x = end; x < width; x++) {
+        sampleEdge(x);
+      }
+    }
+  }
+}
+
+vImageYpCbCrType getFramevImageFormat(OSType pixelFormat) {
+  switch (pixelFormat) {
+    case kCVPixelFormatType_420YpCbCr8BiPlanarFullRange:
+    case kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange:
+      return kvImage420Yp8_CbCr8;
+    case kCVPixelFormatType_420YpCbCr10BiPlanarFullRange:
+    case kCVPixelFormatType_420YpCbCr10BiPlanarVideoRange:
+      throw std::runtime_error("Invalid Pixel Format! 10-bit HDR is not supported.");
+    case kCVPixelFormatType_Lossy_420YpCbCr8BiPlanarFullRange:
+    case kCVPixelFormatType_Lossy_420YpCbCr8BiPlanarVideoRange:
+    case kCVPixelFormatType_Lossy_420YpCbCr10PackedBiPlanarVideoRange:
+      throw std::runtime_error("Invalid Pixel Format! Buffer compression is not supported.");
+    default:
+      throw std::runtime_error("Invalid PixelFormat!");
+  }
+}
+
+vImage_YpCbCrPixelRange getRange(OSType pixelFormat) {
+  // Values are from vImage_Types.h::vImage_YpCbCrPixelRange
+  switch (pixelFormat) {
+    case kCVPixelFormatType_420YpCbCr8BiPlanarFullRange:
+      return (vImage_YpCbCrPixelRange){0, 128, 255, 255, 255, 1, 255, 0};
+    case kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange:
+      return (vImage_YpCbCrPixelRange){16, 128, 235, 240, 235, 16, 240, 16};
+    default:
+      [[unlikely]];
+      @throw [NSException exceptionWithName:@"Unknown YUV pixel format!"
+                                     reason:@"Frame Pixel format is not supported in vImage_YpCbCrPixelRange!"
+                                   userInfo:nil];
+  }
+}
+
+@implementation ResizePipeline {
+  // 1. ??? (?x?) -> ARGB (?x?)
+  FrameBuffer* _argbBuffer;
+  // 2. ARGB (?x?) -> ARGB (!x!)
+  FrameBuffer* _resizeBuffer;
+  FrameBuffer* _warpBuffer;
+  FrameBuffer* _mirrorBuffer;
+  FrameBuffer* _rotateBuffer;
+  // 3. ARGB (!x!) -> !!!! (!x!)
+  FrameBuffer* _convertBuffer;
+  // 3. uint8 -> other type (e.g. float32) if needed
+  FrameBuffer* _customTypeBuffer;
+
+  // Cache
+  void* _tempResizeBuffer;
+  VisionCameraProxyHolder* _proxy;
+}
+
+- (instancetype)initWithProxy:(VisionCameraProxyHolder*)proxy {
+  if (self = [super init]) {
+    _proxy = proxy;
+  }
+  return self;
+}
+
+- (void)dealloc {
+  free(_tempResizeBuffer);
+}
+
+- (FrameBuffer*)convertYUV:(const SourceImage&)image toRGB:(vImageARGBType)targetType {
+  NSLog(@"Converting YUV Frame to RGB...");
+  vImage_Error error = kvImageNoError;
+
+  vImage_YpCbCrPixelRange range = getRange(image.pixelFormat);
+
+  vImage_YpCbCrToARGB info;
+  vImageYpCbCrType sourcevImageFormat = getFramevImageFormat(image.pixelFormat);
+  error = vImageConvert_YpCbCrToARGB_GenerateConversion(kvImage_YpCbCrToARGBMatrix_ITU_R_601_4, &range, &info, sourcevImageFormat,
+                                                        targetType, kvImageNoFlags);
+  if (error != kvImageNoError) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"YUV -> RGB conversion error"
+                                   reason:[NSString stringWithFormat:@"Failed to create YUV -> RGB conversion! Error: %zu", error]
+                                 userInfo:nil];
+  }
+
+  size_t width = image.width;
+  size_t height = image.height;
+  const vImage_Buffer* sourceY = &image.planes[0];
+  const vImage_Buffer* sourceCbCr = &image.planes[1];
+
+  if (_argbBuffer == nil || _argbBuffer.width != width || _argbBuffer.height != height) {
+    _argbBuffer = [[FrameBuffer alloc] initWithWidth:width height:height pixelFormat:ARGB dataType:UINT8 proxy:_proxy];
+  }
+  const vImage_Buffer* destination = _argbBuffer.imageBuffer;
+
+  error = vImageConvert_420Yp8_CbCr8ToARGB8888(sourceY, sourceCbCr, destination, &info, nil, 255, kvImageNoFlags);
+  if (error != kvImageNoError) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"YUV -> RGB conversion error"
+                                   reason:[NSString stringWithFormat:@"Failed to run YUV -> RGB conversion! Error: %zu", error]
+                                 userInfo:nil];
+  }
+
+  return _argbBuffer;
+}
+
+- (FrameBuffer*)convertARGB:(FrameBuffer*)buffer to:(ConvertPixelFormat)destinationFormat {
+  vImage_Error error = kvImageNoError;
+  Pixel_8888 backgroundColor{0, 0, 0, 255};
+
+  // If possible, do all conversions in-memory.
+  FrameBuffer* destinationBuffer = buffer;
+
+  size_t targetBytesPerPixel = [FrameBuffer getBytesPerPixel:destinationFormat withType:UINT8];
+  if (buffer.bytesPerPixel != targetBytesPerPixel) {
+    // The bytes per pixel are not the same, so we need an intermediate array allocation.
+    if (_convertBuffer == nil || _convertBuffer.width != buffer.width || _convertBuffer.height != buffer.height ||
+        _convertBuffer.pixelFormat != destinationFormat) {
+      _convertBuffer = [[FrameBuffer alloc] initWithWidth:buffer.width
+                                                   height:buffer.height
+                                              pixelFormat:destinationFormat
+                                                 dataType:UINT8
+                                                    proxy:_proxy];
+    }
+    destinationBuffer = _convertBuffer;
+  }
+
+  // Source and Destination _might_ be the same buffer.
+  const vImage_Buffer* source = buffer.imageBuffer;
+  const vImage_Buffer* destination = destinationBuffer.imageBuffer;
+
+  switch (destinationFormat) {
+    case RGB: {
+      NSLog(@"Converting ARGB_8 Frame to RGB_8...");
+      error = vImageFlatten_ARGB8888ToRGB888(source, destination, backgroundColor, false, kvImageNoFlags);
+      break;
+    }
+    case BGR: {
+      NSLog(@"Converting ARGB_8 Frame to BGR_8...");
+      error = vImageFlatten_ARGB8888ToRGB888(source, destination, backgroundColor, false, kvImageNoFlags);
+      uint8_t permuteMap[4] = {2, 1, 0};
+      error = vImagePermuteChannels_RGB888(destination, destination, permuteMap, kvImageNoFlags);
+      break;
+    }
+    case ARGB: {
+      // We are already in ARGB_8. No need to do anything.
+      break;
+    }
+    case RGBA: {
+      NSLog(@"Converting ARGB_8 Frame to RGBA_8...");
+      uint8_t permuteMap[4] = {1, 2, 3, 0};
+      error = vImagePermuteChannels_ARGB8888(source, destination, permuteMap, kvImageNoFlags);
+      break;
+    }
+    case BGRA: {
+      NSLog(@"Converting ARGB_8 Frame to BGRA_8...");
+      uint8_t permuteMap[4] = {3, 2, 1, 0};
+      error = vImagePermuteChannels_ARGB8888(source, destination, permuteMap, kvImageNoFlags);
+      break;
+    }
+    case ABGR: {
+      NSLog(@"Converting ARGB_8 Frame to ABGR_8...");
+      uint8_t permuteMap[4] = {0, 3, 2, 1};
+      error = vImagePermuteChannels_ARGB8888(source, destination, permuteMap, kvImageNoFlags);
+      break;
+    }
+  }
+
+  if (error != kvImageNoError) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"RGB Conversion Error"
+                                   reason:[NSString stringWithFormat:@"Failed to convert RGB layout! Error: %zu", error]
+                                 userInfo:nil];
+  }
+
+  return destinationBuffer;
+}
+
+- (FrameBuffer*)convertFrameToARGB:(const SourceImage&)image {
+  NSLog(@"Converting BGRA_8 Frame to ARGB_8...");
+
+  size_t width = image.width;
+  size_t height = image.height;
+
+  if (_argbBuffer == nil || _argbBuffer.width != width || _argbBuffer.height != height) {
+    _argbBuffer = [[FrameBuffer alloc] initWithWidth:width height:height pixelFormat:ARGB dataType:UINT8 proxy:_proxy];
+  }
+
+  const vImage_Buffer* input = &image.planes[0];
+  const vImage_Buffer* destination = _argbBuffer.imageBuffer;
+
+  uint8_t permuteMap[4] = {3, 2, 1, 0};
+  vImage_Error error = vImagePermuteChannels_ARGB8888(input, destination, permuteMap, kvImageNoFlags);
+  if (error != kvImageNoError) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"RGB Conversion Error"
+                                   reason:[NSString stringWithFormat:@"Failed to convert Frame to ARGB! Error: %zu", error]
+                                 userInfo:nil];
+  }
+
+  return _argbBuffer;
+}
+
+- (FrameBuffer*)resizeARGB:(FrameBuffer*)buffer crop:(CGRect)crop scale:(CGSize)scale {
+  CGFloat cropWidth = crop.size.width;
+  CGFloat cropHeight = crop.size.height;
+  CGFloat cropX = crop.origin.x;
+  CGFloat cropY = crop.origin.y;
+
+  CGFloat scaleWidth = scale.width;
+  CGFloat scaleHeight = scale.height;
+
+  if (buffer.width == cropWidth && buffer.height == cropHeight && buffer.width == scaleWidth && buffer.height == scaleHeight &&
+      cropX == 0 && cropY == 0) {
+    // We are already in the target size.
+    NSLog(@"Skipping resize, buffer is already desired size (%f x %f)...", scaleWidth, scaleHeight);
+    return buffer;
+  }
+
+  NSLog(@"Resizing ARGB_8 Frame to %f x %f...", scaleWidth, scaleHeight);
+
+  if (_resizeBuffer == nil || _resizeBuffer.width != scaleWidth || _resizeBuffer.height != scaleHeight) {
+    _resizeBuffer = [[FrameBuffer alloc] initWithWidth:scaleWidth height:scaleHeight pixelFormat:ARGB dataType:UINT8 proxy:_proxy];
+    // reset _tempResizeBuffer as well as that depends on the size
+    free(_tempResizeBuffer);
+    _tempResizeBuffer = nil;
+  }
+  const vImage_Buffer* source = buffer.imageBuffer;
+  const vImage_Buffer* destination = _resizeBuffer.imageBuffer;
+
+  if (_tempResizeBuffer == nil) {
+    size_t tempBufferSize = vImageScale_ARGB8888(source, destination, nil, kvImageGetTempBufferSize);
+    if (tempBufferSize > 0) {
+      NSLog(@"Allocating _tempResizeBuffer (size: %zu)...", tempBufferSize);
+      free(_tempResizeBuffer);
+      _tempResizeBuffer = malloc(tempBufferSize);
+    } else {
+      NSLog(@"Cannot allocate _tempResizeBuffer, size is unknown!");
+    }
+  }
+
+  // Crop
+  vImage_Buffer cropped = (vImage_Buffer){.data = AdvancePtr(source->data, cropY * source->rowBytes + cropX * buffer.bytesPerPixel),
+                                          .height = (unsigned long)cropHeight,
+                                          .width = (unsigned long)cropWidth,
+                                          .rowBytes = source->rowBytes};
+  source = &cropped;
+
+  // Resize
+  vImage_Error error = vImageScale_ARGB8888(source, destination, _tempResizeBuffer, kvImageNoFlags);
+  if (error != kvImageNoError) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"Resize Error"
+                                   reason:[NSString stringWithFormat:@"Failed to resize ARGB buffer! Error: %zu", error]
+                                 userInfo:nil];
+  }
+
+  return _resizeBuffer;
+}
+
+- (FrameBuffer*)warpARGB:(FrameBuffer*)buffer transform:(const double*)transform size:(CGSize)size {
+  NSLog(@"Warping ARGB_8 Frame to %f x %f...", size.width, size.height);
+
+  if (_warpBuffer == nil || _warpBuffer.width != size.width || _warpBuffer.height != size.height) {
+    _warpBuffer = [[FrameBuffer alloc] initWithWidth:size.width height:size.height pixelFormat:ARGB dataType:UINT8 proxy:_proxy];
+  }
+  const vImage_Buffer* source = buffer.imageBuffer;
+  const vImage_Buffer* destination = _warpBuffer.imageBuffer;
+
+  BOOL isAffine = transform[6] == 0.0 && transform[7] == 0.0 && transform[8] == 1.0;
+  if (isAffine) {
+    warpARGBRows<false>(source, destination, transform);
+  } else {
+    warpARGBRows<true>(source, destination, transform);
+  }
+
+  return _warpBuffer;
+}
+
+- (FrameBuffer*)convertInt8Buffer:(FrameBuffer*)buffer toDataType:(ConvertDataType)targetType stats:(FrameStats*)stats {
+  if (stats != nil) {
+    stats->scale = targetType == FLOAT32 ? 1.0f / 255.0f : 1.0f;
+  }
+
+  if (buffer.dataType == targetType) {
+    // we are already in the target type
+    if (stats != nil) {
+      // stats still need one read pass
+      NSLog(@"Computing buffer stats...");
+      accumulateStats<false>(buffer, nil, stats);
+    }
+    return buffer;
+  }
+
+  NSLog(@"Converting uint8 (%zu) buffer to target type (%zu)...", buffer.dataType, targetType);
+
+  if (_customTypeBuffer == nil || _customTypeBuffer.width != buffer.width || _customTypeBuffer.height != buffer.height ||
+      _customTypeBuffer.pixelFormat != buffer.pixelFormat || _customTypeBuffer.dataType != targetType) {
+    _customTypeBuffer = [[FrameBuffer alloc] initWithWidth:buffer.width
+                                                    height:buffer.height
+                                               pixelFormat:buffer.pixelFormat
+                                                  dataType:targetType
+                                                     proxy:_proxy];
+  }
+  const vImage_Buffer* source = buffer.imageBuffer;
+  const vImage_Buffer* destination = _customTypeBuffer.imageBuffer;
+
+  switch (targetType) {
+    case UINT8:
+      break;
+    case FLOAT32: {
+      // Convert uint8 -> float32
+      uint8_t* input = (uint8_t*)source->data;
+      float* output = (float*)destination->data;
+      size_t numBytes = source->height * source->rowBytes;
+      float scale = 1.0f / 255.0f;
+
+      if (stats != nil) {
+        // Accumulate stats in the same pass as the conversion
+        accumulateStats<true>(buffer, output, stats);
+        break;
+      }
+      vDSP_vfltu8(input, 1, output, 1, numBytes);
+      vDSP_vsmul(output, 1, &scale, output, 1, numBytes);
+      break;
+    }
+    default:
+      [[unlikely]];
+      @throw [NSException exceptionWithName:@"Unknown target data type!" reason:@"Data type was unknown" userInfo:nil];
+  }
+
+  return _customTypeBuffer;
+}
+
+- (FrameBuffer*)mirrorARGBBuffer:(FrameBuffer*)buffer mirror:(BOOL)mirror {
+
+  if (!mirror) {
+    return buffer;
+  }
+
+  NSLog(@"Mirroring ARGB buffer...");
+
+  if (_mirrorBuffer == nil || _mirrorBuffer.width != buffer.width || _mirrorBuffer.height != buffer.height) {
+    _mirrorBuffer = [[FrameBuffer alloc] initWithWidth:buffer.width
+                                                height:buffer.height
+                                           pixelFormat:buffer.pixelFormat
+                                              dataType:buffer.dataType
+                                                 proxy:_proxy];
+  }
+
+  vImage_Buffer src = *buffer.imageBuffer;
+  vImage_Buffer dest = *_mirrorBuffer.imageBuffer;
+
+  vImage_Error error = vImageHorizontalReflect_ARGB8888(&src, &dest, kvImageNoFlags);
+  if (error != kvImageNoError) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"Mirror Error"
+                                   reason:[NSString stringWithFormat:@"Failed to mirror ARGB buffer! Error: %zu", error]
+                                 userInfo:nil];
+  }
+
+  return _mirrorBuffer;
+}
+
+- (FrameBuffer*)rotateARGBBuffer:(FrameBuffer*)buffer rotation:(Rotation)rotation {
+  if (rotation == Rotation0) {
+    return buffer;
+  }
+
+  NSLog(@"Rotating ARGB buffer...");
+
+  int rotatedWidth = buffer.width;
+  int rotatedHeight = buffer.height;
+  if (rotation == Rotation90 || rotation == Rotation270) {
+    int temp = rotatedWidth;
+    rotatedWidth = rotatedHeight;
+    rotatedHeight = temp;
+  }
+
+  if (_rotateBuffer == nil || _rotateBuffer.width != rotatedWidth || _rotateBuffer.height != rotatedHeight) {
+    _rotateBuffer = [[FrameBuffer alloc] initWithWidth:rotatedWidth
+                                                height:rotatedHeight
+                                           pixelFormat:buffer.pixelFormat
+                                              dataType:buffer.dataType
+                                                 proxy:_proxy];
+  }
+
+  const vImage_Buffer* src = buffer.imageBuffer;
+  const vImage_Buffer* dest = _rotateBuffer.imageBuffer;
+
+  vImage_Error error = kvImageNoError;
+  Pixel_8888 backgroundColor = {0, 0, 0, 0};
+  switch (rotation) {
+    case Rotation90:
+      error = vImageRotate90_ARGB8888(src, dest, kRotate90DegreesClockwise, backgroundColor, kvImageNoFlags);
+      break;
+    case Rotation180:
+      error = vImageRotate90_ARGB8888(src, dest, kRotate180DegreesClockwise, backgroundColor, kvImageNoFlags);
+      break;
+    case Rotation270:
+      error = vImageRotate90_ARGB8888(src, dest, kRotate270DegreesClockwise, backgroundColor, kvImageNoFlags);
+      break;
+    default:
+      [[unlikely]];
+      @throw [NSException exceptionWithName:@"Invalid Rotation"
+                                     reason:[NSString stringWithFormat:@"Invalid Rotation! (%zu)", rotation]
+                                   userInfo:nil];
+  }
+
+  if (error != kvImageNoError) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"Rotation Error"
+                                   reason:[NSString stringWithFormat:@"Failed to rotate ARGB buffer! Error %ld", error]
+                                 userInfo:nil];
+  }
+
+  return _rotateBuffer;
+}
+
+// Used only for debugging/inspecting the Image.
+- (UIImage*)bufferToImage:(FrameBuffer*)buffer {
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef bitmapContext = CGBitmapContextCreate(buffer.imageBuffer->data, buffer.width, buffer.height,
+                                                     buffer.bytesPerChannel * 8,          // bit per component
+                                                     buffer.width * buffer.bytesPerPixel, // bytes per row
+                                                     colorSpace, kCGImageAlphaNoneSkipLast);
+  CGImageRef cgImage = CGBitmapContextCreateImage(bitmapContext);
+
+  UIImage* image = [UIImage imageWithCGImage:cgImage];
+
+  CGImageRelease(cgImage);
+  CGContextRelease(bitmapContext);
+  CGColorSpaceRelease(colorSpace);
+
+  return image;
+}
+
+- (FrameBuffer*)run:(SourceImage)image options:(ResizeOptions)options stats:(FrameStats*)stats {
+  FrameBuffer* result = nil;
+
+  // 2. Convert from source pixel format (YUV) to a pixel format we can work with (RGB)
+  OSType sourceType = image.pixelFormat;
+  if (sourceType == kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange || sourceType == kCVPixelFormatType_420YpCbCr8BiPlanarFullRange) {
+    // Convert YUV (4:2:0) -> ARGB_8888 first, only then we can operate in RGB layouts
+    result = [self convertYUV:image toRGB:kvImageARGB8888];
+  } else if (sourceType == kCVPixelFormatType_32BGRA) {
+    // Convert BGRA -> ARGB_8888 first, only then we can operate in RGB layouts
+    result = [self convertFrameToARGB:image];
+  } else {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"Invalid PixelFormat"
+                                   reason:@"Frame has invalid Pixel Format! Disable buffer compression and 10-bit HDR."
+                                 userInfo:nil];
+  }
+
+  if (options.hasTransform) {
+    // 3. Warp, samples directly from the full Frame into the target size
+    result = [self warpARGB:result transform:options.transform size:options.scale];
+  } else {
+    // 3. Resize
+    result = [self resizeARGB:result crop:options.crop scale:options.scale];
+  }
+
+  // 4. Rotate
+  result = [self rotateARGBBuffer:result rotation:options.rotation];
+
+  // 5. Mirror
+  result = [self mirrorARGBBuffer:result mirror:options.mirror];
+
+  // 6. Convert ARGB -> ??? format
+  result = [self convertARGB:result to:options.pixelFormat];
+
+  // 7. Convert UINT8 -> ??? type, and compute stats on the way if requested
+  stats->isValid = NO;
+  result = [self convertInt8Buffer:result toDataType:options.dataType stats:options.computeStats ? stats : nil];
+
+  return result;
+}
+
+@end
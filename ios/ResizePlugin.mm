@@ -11,46 +11,171 @@
 #import <VisionCamera/FrameProcessorPluginRegistry.h>
 #import <VisionCamera/SharedArray.h>
 
-#import <Accelerate/Accelerate.h>
+#import <algorithm>
 #import <memory>
+#import <mutex>
 #import <utility>
+#import <vector>
 
 #import "FrameBuffer.h"
-
-typedef NS_ENUM(NSInteger, Rotation) { Rotation0 = 0, Rotation90 = 90, Rotation180 = 180, Rotation270 = 270 };
+#import "ResizePipeline.h"
 
 @interface ResizePlugin : FrameProcessorPlugin
 @end
 
-#define AdvancePtr(_ptr, _bytes) (__typeof__(_ptr))((uintptr_t)(_ptr) + (size_t)(_bytes))
+// A deep copy of a Frame, so it can be processed after the Frame Processor returned the CMSampleBuffer to the Camera
+struct PipelinedFrame {
+  SourceImage image;
+  std::vector<uint8_t> planeData[2];
+  ResizeOptions options;
+  double timestamp;
+  // Created on the Frame Processor Thread, the worker only writes into its memory
+  FrameBuffer* output;
+};
+
+// Wraps the planes of a locked CVPixelBuffer without copying them
+SourceImage getSourceImage(CVPixelBufferRef pixelBuffer) {
+  SourceImage image = {.pixelFormat = CVPixelBufferGetPixelFormatType(pixelBuffer),
+                       .width = CVPixelBufferGetWidth(pixelBuffer),
+                       .height = CVPixelBufferGetHeight(pixelBuffer)};
+  if (CVPixelBufferIsPlanar(pixelBuffer)) {
+    image.planesCount = std::min(CVPixelBufferGetPlaneCount(pixelBuffer), (size_t)2);
+    for (size_t i = 0; i < image.planesCount; i++) {
+      image.planes[i] = {.data = CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, i),
+                         .width = CVPixelBufferGetWidthOfPlane(pixelBuffer, i),
+                         .height = CVPixelBufferGetHeightOfPlane(pixelBuffer, i),
+                         .rowBytes = CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, i)};
+    }
+  } else {
+    image.planesCount = 1;
+    image.planes[0] = {.data = CVPixelBufferGetBaseAddress(pixelBuffer),
+                       .width = image.width,
+                       .height = image.height,
+                       .rowBytes = CVPixelBufferGetBytesPerRow(pixelBuffer)};
+  }
+  return image;
+}
+
+void copyToPipelinedFrame(const SourceImage& image, PipelinedFrame& frame) {
+  frame.image = image;
+  for (size_t i = 0; i < image.planesCount; i++) {
+    // Only re-allocates if the Frame size changed
+    std::vector<uint8_t>& data = frame.planeData[i];
+    size_t size = image.planes[i].height * image.planes[i].rowBytes;
+    data.resize(size);
+    memcpy(data.data(), image.planes[i].data, size);
+    frame.image.planes[i].data = data.data();
+  }
+}
+
+NSDictionary* statsToDictionary(const FrameStats& stats) {
+  NSMutableArray* sum = [NSMutableArray arrayWithCapacity:stats.channels];
+  NSMutableArray* mean = [NSMutableArray arrayWithCapacity:stats.channels];
+  NSMutableArray* min = [NSMutableArray arrayWithCapacity:stats.channels];
+  NSMutableArray* max = [NSMutableArray arrayWithCapacity:stats.channels];
+  for (size_t c = 0; c < stats.channels; c++) {
+    [sum addObject:@(stats.sum[c] * stats.scale)];
+    [mean addObject:@((double)stats.sum[c] / stats.pixelCount * stats.scale)];
+    [min addObject:@(stats.min[c] * stats.scale)];
+    [max addObject:@(stats.max[c] * stats.scale)];
+  }
+  NSMutableArray* histogram = [NSMutableArray arrayWithCapacity:256];
+  for (size_t i = 0; i < 256; i++) {
+    [histogram addObject:@(stats.histogram[i])];
+  }
+  return @{@"sum" : sum, @"mean" : mean, @"min" : min, @"max" : max, @"histogram" : histogram};
+}
+
+// Parses the user's 6 (affine) or 9 (perspective) value source -> target matrix, and inverts it into a target -> source matrix
+void parseTransform(NSDictionary* transform, size_t frameWidth, size_t frameHeight, ResizeOptions* options) {
+  options->hasTransform = transform != nil;
+  if (!options->hasTransform) {
+    return;
+  }
+
+  NSArray* matrix = transform[@"matrix"];
+  if (matrix == nil || (matrix.count != 6 && matrix.count != 9)) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"Invalid Transform" reason:@"Transform matrix must have 6 or 9 values!" userInfo:nil];
+  }
+  double m[9] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+  for (NSUInteger i = 0; i < matrix.count; i++) {
+    m[i] = ((NSNumber*)matrix[i]).doubleValue;
+  }
+
+  // A homography has no fixed scale, so -H is the same warp as H. Flip it so w is positive at the Frame's center,
+  // only then a negative w means that a point is behind the horizon.
+  double centerW = m[6] * frameWidth / 2.0 + m[7] * frameHeight / 2.0 + m[8];
+  if (centerW < 0.0) {
+    for (int i = 0; i < 9; i++) {
+      m[i] = -m[i];
+    }
+  }
+
+  double a = m[4] * m[8] - m[5] * m[7];
+  double b = m[5] * m[6] - m[3] * m[8];
+  double c = m[3] * m[7] - m[4] * m[6];
+  double determinant = m[0] * a + m[1] * b + m[2] * c;
+  if (std::abs(determinant) < 1e-12) {
+    [[unlikely]];
+    @throw [NSException exceptionWithName:@"Invalid Transform" reason:@"Transform matrix is not invertible!" userInfo:nil];
+  }
+  double* inverse = options->transform;
+  inverse[0] = a / determinant;
+  inverse[1] = (m[2] * m[7] - m[1] * m[8]) / determinant;
+  inverse[2] = (m[1] * m[5] - m[2] * m[4]) / determinant;
+  inverse[3] = b / determinant;
+  inverse[4] = (m[0] * m[8] - m[2] * m[6]) / determinant;
+  inverse[5] = (m[2] * m[3] - m[0] * m[5]) / determinant;
+  inverse[6] = c / determinant;
+  inverse[7] = (m[1] * m[6] - m[0] * m[7]) / determinant;
+  inverse[8] = (m[0] * m[4] - m[1] * m[3]) / determinant;
+  // Normalize, so affine matrices take the affine path. This keeps the sign of w, see warpARGBRows.
+  double scale = std::abs(inverse[8]);
+  if (scale != 0.0) {
+    for (int i = 0; i < 9; i++) {
+      inverse[i] /= scale;
+    }
+  }
+}
 
 @implementation ResizePlugin {
-  // 1. ??? (?x?) -> ARGB (?x?)
-  FrameBuffer* _argbBuffer;
-  // 2. ARGB (?x?) -> ARGB (!x!)
-  FrameBuffer* _resizeBuffer;
-  FrameBuffer* _mirrorBuffer;
-  FrameBuffer* _rotateBuffer;
-  // 3. ARGB (!x!) -> !!!! (!x!)
-  FrameBuffer* _convertBuffer;
-  // 3. uint8 -> other type (e.g. float32) if needed
-  FrameBuffer* _customTypeBuffer;
-
-  // Cache
-  void* _tempResizeBuffer;
   VisionCameraProxyHolder* _proxy;
+  // Used by resize() on the Frame Processor Thread
+  ResizePipeline* _pipeline;
+
+  // Pipelined mode: Frames are copied and processed on _workerQueue, which has its own intermediate buffers
+  ResizePipeline* _workerPipeline;
+  dispatch_queue_t _workerQueue;
+  std::mutex _workerMutex;
+  std::unique_ptr<PipelinedFrame> _pendingFrame;
+  std::unique_ptr<PipelinedFrame> _spareFrame;
+  BOOL _isWorkerScheduled;
+  // The outputs are SharedArrays, so they are only created and released on the Frame Processor Thread. The worker writes into the
+  // output of the Frame it processes, and hands it back as _readyOutput (latest completed result) or via _freeOutputs.
+  // _frontOutput is the last one handed to JS.
+  NSMutableArray<FrameBuffer*>* _freeOutputs;
+  FrameBuffer* _readyOutput;
+  FrameBuffer* _frontOutput;
+  double _readyTimestamp;
+  double _frontTimestamp;
+  FrameStats _backStats;
+  FrameStats _readyStats;
+  FrameStats _frontStats;
+  BOOL _hasReadyOutput;
 }
 
 - (instancetype)initWithProxy:(VisionCameraProxyHolder*)proxy withOptions:(NSDictionary*)options {
   if (self = [super initWithProxy:proxy withOptions:options]) {
     _proxy = proxy;
+    _pipeline = [[ResizePipeline alloc] initWithProxy:proxy];
+    _freeOutputs = [NSMutableArray array];
   }
   return self;
 }
 
 - (void)dealloc {
   NSLog(@"Deallocating ResizePlugin...");
-  free(_tempResizeBuffer);
 }
 
 Rotation parseRotation(NSString* rotationString) {
@@ -104,392 +229,6 @@ ConvertDataType parseDataType(NSString* dataType) {
   }
 }
 
-FourCharCode getFramePixelFormat(Frame* frame) {
-  CMFormatDescriptionRef format = CMSampleBufferGetFormatDescription(frame.buffer);
-  return CMFormatDescriptionGetMediaSubType(format);
-}
-
-vImageYpCbCrType getFramevImageFormat(Frame* frame) {
-  FourCharCode subType = getFramePixelFormat(frame);
-  switch (subType) {
-    case kCVPixelFormatType_420YpCbCr8BiPlanarFullRange:
-    case kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange:
-      return kvImage420Yp8_CbCr8;
-    case kCVPixelFormatType_420YpCbCr10BiPlanarFullRange:
-    case kCVPixelFormatType_420YpCbCr10BiPlanarVideoRange:
-      throw std::runtime_error("Invalid Pixel Format! 10-bit HDR is not supported.");
-    case kCVPixelFormatType_Lossy_420YpCbCr8BiPlanarFullRange:
-    case kCVPixelFormatType_Lossy_420YpCbCr8BiPlanarVideoRange:
-    case kCVPixelFormatType_Lossy_420YpCbCr10PackedBiPlanarVideoRange:
-      throw std::runtime_error("Invalid Pixel Format! Buffer compression is not supported.");
-    default:
-      throw std::runtime_error("Invalid PixelFormat!");
-  }
-}
-
-vImage_YpCbCrPixelRange getRange(FourCharCode pixelFormat) {
-  // Values are from vImage_Types.h::vImage_YpCbCrPixelRange
-  switch (pixelFormat) {
-    case kCVPixelFormatType_420YpCbCr8BiPlanarFullRange:
-      return (vImage_YpCbCrPixelRange){0, 128, 255, 255, 255, 1, 255, 0};
-    case kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange:
-      return (vImage_YpCbCrPixelRange){16, 128, 235, 240, 235, 16, 240, 16};
-    default:
-      [[unlikely]];
-      @throw [NSException exceptionWithName:@"Unknown YUV pixel format!"
-                                     reason:@"Frame Pixel format is not supported in vImage_YpCbCrPixelRange!"
-                                   userInfo:nil];
-  }
-}
-
-- (FrameBuffer*)convertYUV:(Frame*)frame toRGB:(vImageARGBType)targetType {
-  NSLog(@"Converting YUV Frame to RGB...");
-  vImage_Error error = kvImageNoError;
-
-  vImage_YpCbCrPixelRange range = getRange(getFramePixelFormat(frame));
-
-  vImage_YpCbCrToARGB info;
-  vImageYpCbCrType sourcevImageFormat = getFramevImageFormat(frame);
-  error = vImageConvert_YpCbCrToARGB_GenerateConversion(kvImage_YpCbCrToARGBMatrix_ITU_R_601_4, &range, &info, sourcevImageFormat,
-                                                        targetType, kvImageNoFlags);
-  if (error != kvImageNoError) {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"YUV -> RGB conversion error"
-                                   reason:[NSString stringWithFormat:@"Failed to create YUV -> RGB conversion! Error: %zu", error]
-                                 userInfo:nil];
-  }
-
-  CVPixelBufferRef pixelBuffer = CMSampleBufferGetImageBuffer(frame.buffer);
-  CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-
-  vImage_Buffer sourceY = {.data = CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 0),
-                           .width = CVPixelBufferGetWidthOfPlane(pixelBuffer, 0),
-                           .height = CVPixelBufferGetHeightOfPlane(pixelBuffer, 0),
-                           .rowBytes = CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 0)};
-  vImage_Buffer sourceCbCr = {.data = CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 1),
-                              .width = CVPixelBufferGetWidthOfPlane(pixelBuffer, 1),
-                              .height = CVPixelBufferGetHeightOfPlane(pixelBuffer, 1),
-                              .rowBytes = CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 1)};
-
-  if (_argbBuffer == nil || _argbBuffer.width != frame.width || _argbBuffer.height != frame.height) {
-    _argbBuffer = [[FrameBuffer alloc] initWithWidth:frame.width height:frame.height pixelFormat:ARGB dataType:UINT8 proxy:_proxy];
-  }
-  const vImage_Buffer* destination = _argbBuffer.imageBuffer;
-
-  error = vImageConvert_420Yp8_CbCr8ToARGB8888(&sourceY, &sourceCbCr, destination, &info, nil, 255, kvImageNoFlags);
-  if (error != kvImageNoError) {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"YUV -> RGB conversion error"
-                                   reason:[NSString stringWithFormat:@"Failed to run YUV -> RGB conversion! Error: %zu", error]
-                                 userInfo:nil];
-  }
-
-  CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-
-  return _argbBuffer;
-}
-
-- (FrameBuffer*)convertARGB:(FrameBuffer*)buffer to:(ConvertPixelFormat)destinationFormat {
-  vImage_Error error = kvImageNoError;
-  Pixel_8888 backgroundColor{0, 0, 0, 255};
-
-  // If possible, do all conversions in-memory.
-  FrameBuffer* destinationBuffer = buffer;
-
-  size_t targetBytesPerPixel = [FrameBuffer getBytesPerPixel:destinationFormat withType:UINT8];
-  if (buffer.bytesPerPixel != targetBytesPerPixel) {
-    // The bytes per pixel are not the same, so we need an intermediate array allocation.
-    if (_convertBuffer == nil || _convertBuffer.width != buffer.width || _convertBuffer.height != buffer.height ||
-        _convertBuffer.pixelFormat != destinationFormat) {
-      _convertBuffer = [[FrameBuffer alloc] initWithWidth:buffer.width
-                                                   height:buffer.height
-                                              pixelFormat:destinationFormat
-                                                 dataType:UINT8
-                                                    proxy:_proxy];
-    }
-    destinationBuffer = _convertBuffer;
-  }
-
-  // Source and Destination _might_ be the same buffer.
-  const vImage_Buffer* source = buffer.imageBuffer;
-  const vImage_Buffer* destination = destinationBuffer.imageBuffer;
-
-  switch (destinationFormat) {
-    case RGB: {
-      NSLog(@"Converting ARGB_8 Frame to RGB_8...");
-      error = vImageFlatten_ARGB8888ToRGB888(source, destination, backgroundColor, false, kvImageNoFlags);
-      break;
-    }
-    case BGR: {
-      NSLog(@"Converting ARGB_8 Frame to BGR_8...");
-      error = vImageFlatten_ARGB8888ToRGB888(source, destination, backgroundColor, false, kvImageNoFlags);
-      uint8_t permuteMap[4] = {2, 1, 0};
-      error = vImagePermuteChannels_RGB888(destination, destination, permuteMap, kvImageNoFlags);
-      break;
-    }
-    case ARGB: {
-      // We are already in ARGB_8. No need to do anything.
-      break;
-    }
-    case RGBA: {
-      NSLog(@"Converting ARGB_8 Frame to RGBA_8...");
-      uint8_t permuteMap[4] = {1, 2, 3, 0};
-      error = vImagePermuteChannels_ARGB8888(source, destination, permuteMap, kvImageNoFlags);
-      break;
-    }
-    case BGRA: {
-      NSLog(@"Converting ARGB_8 Frame to BGRA_8...");
-      uint8_t permuteMap[4] = {3, 2, 1, 0};
-      error = vImagePermuteChannels_ARGB8888(source, destination, permuteMap, kvImageNoFlags);
-      break;
-    }
-    case ABGR: {
-      NSLog(@"Converting ARGB_8 Frame to ABGR_8...");
-      uint8_t permuteMap[4] = {0, 3, 2, 1};
-      error = vImagePermuteChannels_ARGB8888(source, destination, permuteMap, kvImageNoFlags);
-      break;
-    }
-  }
-
-  if (error != kvImageNoError) {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"RGB Conversion Error"
-                                   reason:[NSString stringWithFormat:@"Failed to convert RGB layout! Error: %zu", error]
-                                 userInfo:nil];
-  }
-
-  return destinationBuffer;
-}
-
-- (FrameBuffer*)convertFrameToARGB:(Frame*)frame {
-  NSLog(@"Converting BGRA_8 Frame to ARGB_8...");
-
-  if (_argbBuffer == nil || _argbBuffer.width != frame.width || _argbBuffer.height != frame.height) {
-    _argbBuffer = [[FrameBuffer alloc] initWithWidth:frame.width height:frame.height pixelFormat:ARGB dataType:UINT8 proxy:_proxy];
-  }
-
-  CVPixelBufferRef pixelBuffer = CMSampleBufferGetImageBuffer(frame.buffer);
-  CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-
-  vImage_Buffer input{
-      .data = CVPixelBufferGetBaseAddress(pixelBuffer), .width = frame.width, .height = frame.height, .rowBytes = frame.bytesPerRow};
-  const vImage_Buffer* destination = _argbBuffer.imageBuffer;
-
-  uint8_t permuteMap[4] = {3, 2, 1, 0};
-  vImage_Error error = vImagePermuteChannels_ARGB8888(&input, destination, permuteMap, kvImageNoFlags);
-  if (error != kvImageNoError) {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"RGB Conversion Error"
-                                   reason:[NSString stringWithFormat:@"Failed to convert Frame to ARGB! Error: %zu", error]
-                                 userInfo:nil];
-  }
-
-  CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
-
-  return _argbBuffer;
-}
-
-- (FrameBuffer*)resizeARGB:(FrameBuffer*)buffer crop:(CGRect)crop scale:(CGSize)scale {
-  CGFloat cropWidth = crop.size.width;
-  CGFloat cropHeight = crop.size.height;
-  CGFloat cropX = crop.origin.x;
-  CGFloat cropY = crop.origin.y;
-
-  CGFloat scaleWidth = scale.width;
-  CGFloat scaleHeight = scale.height;
-
-  if (buffer.width == cropWidth && buffer.height == cropHeight && buffer.width == scaleWidth && buffer.height == scaleHeight &&
-      cropX == 0 && cropY == 0) {
-    // We are already in the target size.
-    NSLog(@"Skipping resize, buffer is already desired size (%f x %f)...", scaleWidth, scaleHeight);
-    return buffer;
-  }
-
-  NSLog(@"Resizing ARGB_8 Frame to %f x %f...", scaleWidth, scaleHeight);
-
-  if (_resizeBuffer == nil || _resizeBuffer.width != scaleWidth || _resizeBuffer.height != scaleHeight) {
-    _resizeBuffer = [[FrameBuffer alloc] initWithWidth:scaleWidth height:scaleHeight pixelFormat:ARGB dataType:UINT8 proxy:_proxy];
-    // reset _tempResizeBuffer as well as that depends on the size
-    free(_tempResizeBuffer);
-    _tempResizeBuffer = nil;
-  }
-  const vImage_Buffer* source = buffer.imageBuffer;
-  const vImage_Buffer* destination = _resizeBuffer.imageBuffer;
-
-  if (_tempResizeBuffer == nil) {
-    size_t tempBufferSize = vImageScale_ARGB8888(source, destination, nil, kvImageGetTempBufferSize);
-    if (tempBufferSize > 0) {
-      NSLog(@"Allocating _tempResizeBuffer (size: %zu)...", tempBufferSize);
-      free(_tempResizeBuffer);
-      _tempResizeBuffer = malloc(tempBufferSize);
-    } else {
-      NSLog(@"Cannot allocate _tempResizeBuffer, size is unknown!");
-    }
-  }
-
-  // Crop
-  vImage_Buffer cropped = (vImage_Buffer){.data = AdvancePtr(source->data, cropY * source->rowBytes + cropX * buffer.bytesPerPixel),
-                                          .height = (unsigned long)cropHeight,
-                                          .width = (unsigned long)cropWidth,
-                                          .rowBytes = source->rowBytes};
-  source = &cropped;
-
-  // Resize
-  vImage_Error error = vImageScale_ARGB8888(source, destination, _tempResizeBuffer, kvImageNoFlags);
-  if (error != kvImageNoError) {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"Resize Error"
-                                   reason:[NSString stringWithFormat:@"Failed to resize ARGB buffer! Error: %zu", error]
-                                 userInfo:nil];
-  }
-
-  return _resizeBuffer;
-}
-
-- (FrameBuffer*)convertInt8Buffer:(FrameBuffer*)buffer toDataType:(ConvertDataType)targetType {
-  if (buffer.dataType == targetType) {
-    // we are already in the target type
-    return buffer;
-  }
-
-  NSLog(@"Converting uint8 (%zu) buffer to target type (%zu)...", buffer.dataType, targetType);
-
-  if (_customTypeBuffer == nil || _customTypeBuffer.width != buffer.width || _customTypeBuffer.height != buffer.height ||
-      _customTypeBuffer.pixelFormat != buffer.pixelFormat || _customTypeBuffer.dataType != targetType) {
-    _customTypeBuffer = [[FrameBuffer alloc] initWithWidth:buffer.width
-                                                    height:buffer.height
-                                               pixelFormat:buffer.pixelFormat
-                                                  dataType:targetType
-                                                     proxy:_proxy];
-  }
-  const vImage_Buffer* source = buffer.imageBuffer;
-  const vImage_Buffer* destination = _customTypeBuffer.imageBuffer;
-
-  switch (targetType) {
-    case UINT8:
-      break;
-    case FLOAT32: {
-      // Convert uint8 -> float32
-      uint8_t* input = (uint8_t*)source->data;
-      float* output = (float*)destination->data;
-      size_t numBytes = source->height * source->rowBytes;
-      float scale = 1.0f / 255.0f;
-
-      vDSP_vfltu8(input, 1, output, 1, numBytes);
-      vDSP_vsmul(output, 1, &scale, output, 1, numBytes);
-      break;
-    }
-    default:
-      [[unlikely]];
-      @throw [NSException exceptionWithName:@"Unknown target data type!" reason:@"Data type was unknown" userInfo:nil];
-  }
-
-  return _customTypeBuffer;
-}
-
-- (FrameBuffer*)mirrorARGBBuffer:(FrameBuffer*)buffer mirror:(BOOL)mirror {
-
-  if (!mirror) {
-    return buffer;
-  }
-
-  NSLog(@"Mirroring ARGB buffer...");
-
-  if (_mirrorBuffer == nil || _mirrorBuffer.width != buffer.width || _mirrorBuffer.height != buffer.height) {
-    _mirrorBuffer = [[FrameBuffer alloc] initWithWidth:buffer.width
-                                                height:buffer.height
-                                           pixelFormat:buffer.pixelFormat
-                                              dataType:buffer.dataType
-                                                 proxy:_proxy];
-  }
-
-  vImage_Buffer src = *buffer.imageBuffer;
-  vImage_Buffer dest = *_mirrorBuffer.imageBuffer;
-
-  vImage_Error error = vImageHorizontalReflect_ARGB8888(&src, &dest, kvImageNoFlags);
-  if (error != kvImageNoError) {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"Mirror Error"
-                                   reason:[NSString stringWithFormat:@"Failed to mirror ARGB buffer! Error: %zu", error]
-                                 userInfo:nil];
-  }
-
-  return _mirrorBuffer;
-}
-
-- (FrameBuffer*)rotateARGBBuffer:(FrameBuffer*)buffer rotation:(Rotation)rotation {
-  if (rotation == Rotation0) {
-    return buffer;
-  }
-
-  NSLog(@"Rotating ARGB buffer...");
-
-  int rotatedWidth = buffer.width;
-  int rotatedHeight = buffer.height;
-  if (rotation == Rotation90 || rotation == Rotation270) {
-    int temp = rotatedWidth;
-    rotatedWidth = rotatedHeight;
-    rotatedHeight = temp;
-  }
-
-  if (_rotateBuffer == nil || _rotateBuffer.width != rotatedWidth || _rotateBuffer.height != rotatedHeight) {
-    _rotateBuffer = [[FrameBuffer alloc] initWithWidth:rotatedWidth
-                                                height:rotatedHeight
-                                           pixelFormat:buffer.pixelFormat
-                                              dataType:buffer.dataType
-                                                 proxy:_proxy];
-  }
-
-  const vImage_Buffer* src = buffer.imageBuffer;
-  const vImage_Buffer* dest = _rotateBuffer.imageBuffer;
-
-  vImage_Error error = kvImageNoError;
-  Pixel_8888 backgroundColor = {0, 0, 0, 0};
-  switch (rotation) {
-    case Rotation90:
-      error = vImageRotate90_ARGB8888(src, dest, kRotate90DegreesClockwise, backgroundColor, kvImageNoFlags);
-      break;
-    case Rotation180:
-      error = vImageRotate90_ARGB8888(src, dest, kRotate180DegreesClockwise, backgroundColor, kvImageNoFlags);
-      break;
-    case Rotation270:
-      error = vImageRotate90_ARGB8888(src, dest, kRotate270DegreesClockwise, backgroundColor, kvImageNoFlags);
-      break;
-    default:
-      [[unlikely]];
-      @throw [NSException exceptionWithName:@"Invalid Rotation"
-                                     reason:[NSString stringWithFormat:@"Invalid Rotation! (%zu)", rotation]
-                                   userInfo:nil];
-  }
-
-  if (error != kvImageNoError) {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"Rotation Error"
-                                   reason:[NSString stringWithFormat:@"Failed to rotate ARGB buffer! Error %ld", error]
-                                 userInfo:nil];
-  }
-
-  return _rotateBuffer;
-}
-
-// Used only for debugging/inspecting the Image.
-- (UIImage*)bufferToImage:(FrameBuffer*)buffer {
-  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-  CGContextRef bitmapContext = CGBitmapContextCreate(buffer.sharedArray.data, buffer.width, buffer.height,
-                                                     buffer.bytesPerChannel * 8,          // bit per component
-                                                     buffer.width * buffer.bytesPerPixel, // bytes per row
-                                                     colorSpace, kCGImageAlphaNoneSkipLast);
-  CGImageRef cgImage = CGBitmapContextCreateImage(bitmapContext);
-
-  UIImage* image = [UIImage imageWithCGImage:cgImage];
-
-  CGImageRelease(cgImage);
-  CGContextRelease(bitmapContext);
-  CGColorSpaceRelease(colorSpace);
-
-  return image;
-}
-
 - (id)callback:(Frame*)frame withArguments:(NSDictionary*)arguments {
 
   // 1. Parse inputs
@@ -521,12 +260,16 @@ vImage_YpCbCrPixelRange getRange(FourCharCode pixelFormat) {
   }
   NSLog(@"ResizePlugin: Mirror: %@", mirror ? @"YES" : @"NO");
 
+  NSDictionary* transform = arguments[@"transform"];
+
   double cropWidth = (double)frame.width;
   double cropHeight = (double)frame.height;
   double cropX = 0;
   double cropY = 0;
   NSDictionary* crop = arguments[@"crop"];
-  if (crop != nil) {
+  if (transform != nil) {
+    NSLog(@"ResizePlugin: Transform is set, crop will be ignored.");
+  } else if (crop != nil) {
     cropWidth = ((NSNumber*)crop[@"width"]).doubleValue;
     cropHeight = ((NSNumber*)crop[@"height"]).doubleValue;
     cropX = ((NSNumber*)crop[@"x"]).doubleValue;
@@ -572,44 +315,196 @@ vImage_YpCbCrPixelRange getRange(FourCharCode pixelFormat) {
     NSLog(@"ResizePlugin: No custom data type supplied.");
   }
 
-  FrameBuffer* result = nil;
-
-  // 2. Convert from source pixel format (YUV) to a pixel format we can work with (RGB)
-  FourCharCode sourceType = getFramePixelFormat(frame);
-  if (sourceType == kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange || sourceType == kCVPixelFormatType_420YpCbCr8BiPlanarFullRange) {
-    // Convert YUV (4:2:0) -> ARGB_8888 first, only then we can operate in RGB layouts
-    result = [self convertYUV:frame toRGB:kvImageARGB8888];
-  } else if (sourceType == kCVPixelFormatType_32BGRA) {
-    // Convert BGRA -> ARGB_8888 first, only then we can operate in RGB layouts
-    result = [self convertFrameToARGB:frame];
-  } else {
-    [[unlikely]];
-    @throw [NSException exceptionWithName:@"Invalid PixelFormat"
-                                   reason:@"Frame has invalid Pixel Format! Disable buffer compression and 10-bit HDR."
-                                 userInfo:nil];
+  NSNumber* statsParam = arguments[@"stats"];
+  BOOL computeStats = NO;
+  if (statsParam != nil) {
+    computeStats = [statsParam boolValue];
   }
+  NSLog(@"ResizePlugin: Stats: %@", computeStats ? @"YES" : @"NO");
 
-  // 3. Resize
-  CGRect cropRect = CGRectMake(cropX, cropY, cropWidth, cropHeight);
-  CGSize scaleSize = CGSizeMake(scaleWidth, scaleHeight);
-  result = [self resizeARGB:result crop:cropRect scale:scaleSize];
-
-  // 4. Rotate
-  result = [self rotateARGBBuffer:result rotation:rotation];
+  NSNumber* pipelinedParam = arguments[@"pipelined"];
+  BOOL pipelined = NO;
+  if (pipelinedParam != nil) {
+    pipelined = [pipelinedParam boolValue];
+  }
+  NSLog(@"ResizePlugin: Pipelined: %@", pipelined ? @"YES" : @"NO");
 
-  // 5. Mirror
-  result = [self mirrorARGBBuffer:result mirror:mirror];
+  ResizeOptions options = {
+      .crop = CGRectMake(cropX, cropY, cropWidth, cropHeight),
+      .scale = CGSizeMake(scaleWidth, scaleHeight),
+      .rotation = rotation,
+      .mirror = mirror,
+      .pixelFormat = pixelFormat,
+      .dataType = dataType,
+      .computeStats = computeStats,
+  };
+  parseTransform(transform, frame.width, frame.height, &options);
 
-  // 6. Convert ARGB -> ??? format
-  result = [self convertARGB:result to:pixelFormat];
+  if (pipelined) {
+    return [self resizePipelined:frame options:options];
+  }
 
-  // 7. Convert UINT8 -> ??? type
-  result = [self convertInt8Buffer:result toDataType:dataType];
+  FrameStats stats;
+  CVPixelBufferRef pixelBuffer = CMSampleBufferGetImageBuffer(frame.buffer);
+  CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+  FrameBuffer* result;
+  @try {
+    result = [_pipeline run:getSourceImage(pixelBuffer) options:options stats:&stats];
+  } @finally {
+    CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+  }
 
   // 8. Return to JS
+  if (computeStats) {
+    return @{@"buffer" : result.sharedArray, @"stats" : statsToDictionary(stats)};
+  }
   return result.sharedArray;
 }
 
+- (id)resizePipelined:(Frame*)frame options:(ResizeOptions)options {
+  std::unique_ptr<PipelinedFrame> pipelinedFrame;
+  {
+    std::unique_lock lock(_workerMutex);
+    pipelinedFrame = std::move(_spareFrame);
+  }
+  if (pipelinedFrame == nullptr) {
+    pipelinedFrame = std::make_unique<PipelinedFrame>();
+  }
+
+  // 1. Copy the planes, the CMSampleBuffer goes back to the Camera's pool once the Frame Processor returns
+  CVPixelBufferRef pixelBuffer = CMSampleBufferGetImageBuffer(frame.buffer);
+  CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+  copyToPipelinedFrame(getSourceImage(pixelBuffer), *pipelinedFrame);
+  CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+  pipelinedFrame->options = options;
+  pipelinedFrame->timestamp = frame.timestamp;
+
+  std::unique_lock lock(_workerMutex);
+  // 2. Give it an output to write into. SharedArrays can only be created on the Frame Processor Thread, so this happens here.
+  size_t outputWidth = (size_t)options.scale.width;
+  size_t outputHeight = (size_t)options.scale.height;
+  if (options.rotation == Rotation90 || options.rotation == Rotation270) {
+    std::swap(outputWidth, outputHeight);
+  }
+  for (FrameBuffer* output in [_freeOutputs copy]) {
+    if (output.width == outputWidth && output.height == outputHeight && output.pixelFormat == options.pixelFormat &&
+        output.dataType == options.dataType) {
+      pipelinedFrame->output = output;
+      [_freeOutputs removeObject:output];
+      break;
+    }
+    // The target size or format changed, so this one is never going to be used again
+    [_freeOutputs removeObject:output];
+  }
+  if (pipelinedFrame->output == nil) {
+    NSLog(@"ResizePlugin: Allocating pipelined output (%zu x %zu)...", outputWidth, outputHeight);
+    pipelinedFrame->output = [[FrameBuffer alloc] initWithWidth:outputWidth
+                                                         height:outputHeight
+                                                    pixelFormat:options.pixelFormat
+                                                       dataType:options.dataType
+                                                          proxy:_proxy];
+  }
+
+  // 3. Hand it to the worker. If it did not pick up the previous one yet, that one gets dropped.
+  if (_pendingFrame != nullptr) {
+    [_freeOutputs addObject:_pendingFrame->output];
+    _pendingFrame->output = nil;
+    if (_spareFrame == nullptr) {
+      _spareFrame = std::move(_pendingFrame);
+    }
+  }
+  _pendingFrame = std::move(pipelinedFrame);
+  if (!_isWorkerScheduled) {
+    if (_workerQueue == nil) {
+      NSLog(@"ResizePlugin: Creating pipelined resize worker queue...");
+      _workerQueue = dispatch_queue_create("com.visioncameraresizeplugin.pipelined", DISPATCH_QUEUE_SERIAL);
+      _workerPipeline = [[ResizePipeline alloc] initWithProxy:nil];
+    }
+    _isWorkerScheduled = YES;
+    dispatch_async(_workerQueue, ^{
+      [self runPipelinedWorker];
+    });
+  }
+
+  // 4. Take the most recently completed result, if any. The previous one stays valid until the next call, then it is reused.
+  if (_hasReadyOutput) {
+    if (_frontOutput != nil) {
+      [_freeOutputs addObject:_frontOutput];
+    }
+    _frontOutput = _readyOutput;
+    _readyOutput = nil;
+    std::swap(_frontTimestamp, _readyTimestamp);
+    std::swap(_frontStats, _readyStats);
+    _hasReadyOutput = NO;
+  }
+  lock.unlock();
+  if (_frontOutput == nil) {
+    return nil;
+  }
+
+  NSString* dataType = _frontOutput.dataType == FLOAT32 ? @"float32" : @"uint8";
+  if (_frontStats.isValid) {
+    return @{
+      @"buffer" : _frontOutput.sharedArray,
+      @"timestamp" : @(_frontTimestamp),
+      @"dataType" : dataType,
+      @"stats" : statsToDictionary(_frontStats)
+    };
+  }
+  return @{@"buffer" : _frontOutput.sharedArray, @"timestamp" : @(_frontTimestamp), @"dataType" : dataType};
+}
+
+- (void)runPipelinedWorker {
+  while (true) {
+    std::unique_ptr<PipelinedFrame> frame;
+    {
+      std::unique_lock lock(_workerMutex);
+      if (_pendingFrame == nullptr) {
+        _isWorkerScheduled = NO;
+        return;
+      }
+      frame = std::move(_pendingFrame);
+    }
+
+    FrameBuffer* output = frame->output;
+    BOOL isCompleted = NO;
+    @try {
+      FrameBuffer* result = [_workerPipeline run:frame->image options:frame->options stats:&_backStats];
+      if (result.width != output.width || result.height != output.height || result.pixelFormat != output.pixelFormat ||
+          result.dataType != output.dataType) {
+        [[unlikely]];
+        @throw [NSException exceptionWithName:@"Invalid Output" reason:@"Pipelined output does not match the result!" userInfo:nil];
+      }
+
+      // Copy the result out of the intermediate buffers so the next Frame can be processed while JS still reads this one
+      memcpy(output.imageBuffer->data, result.imageBuffer->data, result.imageBuffer->height * result.imageBuffer->rowBytes);
+      isCompleted = YES;
+    } @catch (NSException* exception) {
+      NSLog(@"ResizePlugin: Failed to resize pipelined Frame! %@", exception.reason);
+    }
+
+    // Outputs are never released here, since that would destroy a SharedArray outside of the Frame Processor Thread
+    std::unique_lock lock(_workerMutex);
+    frame->output = nil;
+    if (isCompleted) {
+      if (_readyOutput != nil) {
+        [_freeOutputs addObject:_readyOutput];
+      }
+      _readyOutput = output;
+      _readyTimestamp = frame->timestamp;
+      std::swap(_backStats, _readyStats);
+      _hasReadyOutput = YES;
+    } else {
+      [_freeOutputs addObject:output];
+    }
+    output = nil;
+    if (_spareFrame == nullptr) {
+      // Keep the allocation around for the next Frame
+      _spareFrame = std::move(frame);
+    }
+  }
+}
+
 VISION_EXPORT_FRAME_PROCESSOR(ResizePlugin, resize);
 
 @end
@@ -30,6 +30,17 @@ interface Rect extends Size {
   y: number;
 }
 
+interface Transform {
+  /**
+   * A row-major matrix that maps Frame pixel coordinates to target pixel coordinates,
+   * like the matrices used by OpenCV's `warpAffine` and `warpPerspective`.
+   *
+   * - 6 values (`[a, b, c, d, e, f]`): An affine transform, e.g. a similarity transform estimated from face landmarks
+   * - 9 values (`[a, b, c, d, e, f, g, h, i]`): A perspective transform, e.g. for rectifying a document
+   */
+  matrix: number[];
+}
+
 export interface Options<T extends DataType> {
   /**
    * If set to `true`, the image will be mirrored horizontally.
@@ -45,6 +56,15 @@ export interface Options<T extends DataType> {
    * Scale the image to the given target size. This is applied after cropping.
    */
   scale?: Size;
+  /**
+   * Warps the image with the given affine or perspective transform.
+   *
+   * Every pixel of the target image (of size `scale`) is bilinearly sampled directly from the Frame,
+   * so this replaces `crop` and `scale`'s center-crop. Samples up to one pixel outside of the Frame
+   * repeat its edge pixels, anything further outside is 0.
+   * Rotation, mirroring, pixel format and data type conversions are applied afterwards.
+   */
+  transform?: Transform;
   /**
    * Rotate the image by a given amount of degrees, clockwise.
    * @default '0deg'
@@ -69,6 +89,71 @@ export interface Options<T extends DataType> {
    * - `'float32'`: Resulting buffer is a `Float32Array`, values range from 0.0 to 1.0
    */
   dataType: T;
+  /**
+   * If set to `true`, statistics of the resulting buffer are computed
+   * while converting it, and returned next to the buffer.
+   *
+   * This is cheaper than iterating over the buffer again in JS.
+   * @see FrameStats
+   */
+  stats?: boolean;
+}
+
+/**
+ * Statistics of a resized buffer.
+ *
+ * Per-channel values are in the order of the target `pixelFormat` (e.g. `[r, g, b]` for `'rgb'`),
+ * and in the value range of the target `dataType` (0...255 for `'uint8'`, 0.0...1.0 for `'float32'`).
+ */
+export interface FrameStats {
+  /**
+   * The sum of all values, per channel.
+   */
+  sum: number[];
+  /**
+   * The mean of all values, per channel.
+   */
+  mean: number[];
+  /**
+   * The smallest value, per channel.
+   */
+  min: number[];
+  /**
+   * The largest value, per channel.
+   */
+  max: number[];
+  /**
+   * A 256-bin histogram of the luma (BT.601) of all pixels.
+   * Bin `i` contains the number of pixels with a luma of `i` (0...255).
+   */
+  histogram: number[];
+}
+
+export interface ResultWithStats<T extends DataType> {
+  /**
+   * The resized and converted buffer.
+   */
+  data: OutputArray<T>;
+  /**
+   * Statistics of `data`.
+   */
+  stats: FrameStats;
+}
+
+export interface PipelinedResult<T extends DataType> {
+  /**
+   * The resized and converted buffer of a previous Frame.
+   */
+  data: OutputArray<T>;
+  /**
+   * The timestamp of the Frame that `data` was computed from.
+   * This uses the same clock as `Frame.timestamp`.
+   */
+  timestamp: number;
+  /**
+   * Statistics of `data`, if `stats` was set to `true`.
+   */
+  stats?: FrameStats;
 }
 
 /**
@@ -82,7 +167,35 @@ export interface ResizePlugin {
    * Resizes the given Frame to the target width/height and
    * convert it to the given pixel format.
    */
-  resize<T extends DataType>(frame: Frame, options: Options<T>): OutputArray<T>;
+  resize<T extends DataType>(
+    frame: Frame,
+    options: Options<T> & { stats?: false }
+  ): OutputArray<T>;
+  resize<T extends DataType>(
+    frame: Frame,
+    options: Options<T> & { stats: true }
+  ): ResultWithStats<T>;
+  resize<T extends DataType>(
+    frame: Frame,
+    options: Options<T>
+  ): OutputArray<T> | ResultWithStats<T>;
+  /**
+   * Copies the given Frame and resizes it on a background thread,
+   * while returning the most recently completed result of a previous Frame.
+   *
+   * This allows resizing the next Frame while the current result is being processed
+   * (e.g. by running inference on it), so throughput is bounded by the slower of the two
+   * instead of their sum - at the cost of one Frame of latency.
+   *
+   * Returns `undefined` if no Frame has been resized yet.
+   * The returned buffer stays valid until the next call to `resizePipelined`.
+   * If `dataType` changes between calls, the first result after the change
+   * still has the previous `dataType`.
+   */
+  resizePipelined<T extends DataType>(
+    frame: Frame,
+    options: Options<T>
+  ): PipelinedResult<T> | undefined;
 }
 
 /**
@@ -100,25 +213,73 @@ export function createResizePlugin(): ResizePlugin {
     );
   }
 
+  const wrapArrayBuffer = <T extends DataType>(
+    arrayBuffer: ArrayBuffer,
+    dataType: T
+  ): OutputArray<T> => {
+    'worklet';
+    switch (dataType) {
+      case 'uint8':
+        // @ts-expect-error
+        return new Uint8Array(arrayBuffer);
+      case 'float32':
+        // @ts-expect-error
+        return new Float32Array(arrayBuffer);
+      default:
+        throw new Error(`Invalid data type (${dataType})!`);
+    }
+  };
+
   return {
-    resize: <T extends DataType>(
+    resize: (<T extends DataType>(
       frame: Frame,
       options: Options<T>
-    ): OutputArray<T> => {
+    ): OutputArray<T> | ResultWithStats<T> => {
       'worklet';
+      if (options.stats) {
+        // @ts-expect-error
+        const result = resizePlugin.call(frame, options) as {
+          buffer: ArrayBuffer;
+          stats: FrameStats;
+        };
+        return {
+          data: wrapArrayBuffer(result.buffer, options.dataType),
+          stats: result.stats,
+        };
+      }
+
       // @ts-expect-error
       const arrayBuffer = resizePlugin.call(frame, options) as ArrayBuffer;
 
-      switch (options.dataType) {
-        case 'uint8':
-          // @ts-expect-error
-          return new Uint8Array(arrayBuffer);
-        case 'float32':
-          // @ts-expect-error
-          return new Float32Array(arrayBuffer);
-        default:
-          throw new Error(`Invalid data type (${options.dataType})!`);
+      return wrapArrayBuffer(arrayBuffer, options.dataType);
+    }) as ResizePlugin['resize'],
+    resizePipelined: <T extends DataType>(
+      frame: Frame,
+      options: Options<T>
+    ): PipelinedResult<T> | undefined => {
+      'worklet';
+      // @ts-expect-error
+      const result = resizePlugin.call(frame, {
+        ...options,
+        pipelined: true,
+      }) as
+        | {
+            buffer: ArrayBuffer;
+            timestamp: number;
+            dataType: T;
+            stats?: FrameStats;
+          }
+        | undefined;
+      if (result == null) {
+        return undefined;
       }
+
+      // The result is from a previous Frame, so its type is the one that Frame was resized with
+      return {
+        data: wrapArrayBuffer(result.buffer, result.dataType),
+        timestamp: result.timestamp,
+        stats: result.stats,
+      };
     },
   };
 }